@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "AudioBackend/Simd.hpp"
+#include "config.hpp"
+#include "Logger.hpp"
+
+/*
+ * Logs the time per sample and the maximum error of each approximated function for every precision, compared to libm.
+ * Error bounds listed in Simd.cpp come from this benchmark.
+*/
+
+static constexpr int SAMPLES = 64 * MAX_BLOCK_FRAMES; // Inputs checked for the error
+static constexpr int REPEATS = 4096; // Blocks processed for the timing
+static constexpr float PI = 3.14159265358979f;
+
+struct Function {
+	const char* name;
+	float minInput, maxInput;
+	bool relativeError;
+	double (*reference)(double);
+	void (*run)(float*, const float*, int);
+};
+
+int main()
+{
+	const Function functions[] = {
+		{ "tanh", -6.0f, 6.0f, false, [](double x) { return std::tanh(x); },
+			[](float* out, const float* in, int frames) { Simd::tanhScale(out, in, 1.0f, frames); } },
+		{ "sin", -PI, PI, false, [](double x) { return std::sin(x); },
+			[](float* out, const float* in, int frames) { Simd::sine(out, in, frames); } },
+		{ "exp2", -10.0f, 10.0f, true, [](double x) { return std::exp2(x); },
+			[](float* out, const float* in, int frames) { Simd::exp2(out, in, frames); } },
+	};
+
+	std::vector<float> inputs(SAMPLES), outputs(SAMPLES);
+	Logger::log("Simd", Info) << "Benchmark of the " << Simd::getLevelName(Simd::getLevel()) << " kernels, time per sample and maximum error:" << std::endl;
+
+	for (const Function& function : functions)
+	{
+		for (int i = 0; i < SAMPLES; i++)
+			inputs[i] = function.minInput + (function.maxInput - function.minInput) * i / (SAMPLES - 1);
+
+		LoggerStream stream = Logger::log("Simd", Info);
+		stream << function.name;
+		for (int p = Simd::Fast; p <= Simd::Exact; p++)
+		{
+			const Simd::Precision precision = static_cast<Simd::Precision>(p);
+			Simd::setPrecision(precision);
+
+			double error = 0.0;
+			function.run(outputs.data(), inputs.data(), SAMPLES);
+			for (int i = 0; i < SAMPLES; i++)
+			{
+				const double expected = function.reference(inputs[i]);
+				const double difference = std::abs(outputs[i] - expected);
+				error = std::max(error, function.relativeError ? difference / std::abs(expected) : difference);
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			for (int repeat = 0; repeat < REPEATS; repeat++)
+				function.run(outputs.data(), inputs.data() + (repeat % 64) * MAX_BLOCK_FRAMES, MAX_BLOCK_FRAMES);
+			const std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+
+			stream << " | " << Simd::getPrecisionName(precision) << (precision == Simd::Exact ? " (libm) " : " ")
+				<< duration.count() / (REPEATS * MAX_BLOCK_FRAMES) << " ns, " << error;
+		}
+		stream << std::endl;
+	}
+	return 0;
+}
@@ -4,9 +4,15 @@
 #include <cstring>
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <RtAudio.h>
 
 #include "AudioBackend/Instrument.hpp"
+#include "RingBuffer.hpp"
 #include "inc.hpp"
 
 #include "Logger.hpp"
@@ -22,7 +28,13 @@ public:
 	);
 	~Audio();
 
-	void update(std::vector<Instrument>& instruments, std::vector<MidiInfo>& keyPressed);
+	// Synthesis runs on its own thread, woken up by the audio callback each time it consumed samples.
+	// instruments must outlive the render thread (see stopRenderThread).
+	void startRenderThread(std::vector<Instrument>& instruments);
+	void stopRenderThread();
+
+	// Called by the UI thread to hand over the keys state to the render thread
+	void publishKeyPressed(const VoicePool& keyPressed);
 
 	bool mute = false;
 
@@ -33,11 +45,17 @@ public:
 	double getSamplesPerUpdate() const;
 	unsigned int getSampleRate() const;
 	unsigned int getWriteCursorPos() const;
-	const float* getBuffer() const;
 	unsigned int getTargetFPS() const;
 	// cursor 0 == left phase, cursor 1 == right phase
 	unsigned int getReadCursorPos(const unsigned int& cusor = 0) const;
 
+	// Called by the UI thread to copy the samples played since the last call in the snapshot
+	void updateSnapshot();
+	// Last played samples (interleaved, getBufferSize() long), only meant to be used by the UI thread
+	const float* getSnapshot() const;
+	// Position following the last played sample in the snapshot
+	unsigned int getSnapshotCursorPos() const;
+
 	bool setLatency(unsigned int bufferFrameOffset);
 	bool setSampleRate(unsigned int sampleRate);
 	bool setChannelNumber(unsigned int channelNumber);
@@ -60,22 +78,36 @@ private:
 
 	// Buffer frame offset between the read and write cursor (buffer frame value is defined by rtAudio).
 	// On slow computer, a too small value may cause the read cusor to overtake the write cursor.
-	unsigned int _latency;
+	// Set by the UI thread while the render thread is running.
+	std::atomic<unsigned int> _latency;
+	static constexpr unsigned int MAX_LATENCY = 30;
 
 	unsigned int _targetFPS;
 
 	// ----------------- INTERNAL DATA -----------------
-	std::unique_ptr<float[]> _buffer;
-	unsigned int _leftPhase, _rightPhase; // Read cursors
-	unsigned int _writeCursor;
-	bool _syncCursors;
-	int _samplesToAdjust; // Used to keep read and write cursors synced in case of lag or inconsistant number of samples read over time
+	RingBuffer<float> _buffer; // Interleaved samples, written by the render thread and read by the audio callback
+	std::vector<float> _renderBuffer; // Samples generated by the render thread before being pushed to _buffer
+	RingBuffer<float> _playedBuffer; // Samples sent to the device, written by the audio callback and read by the UI thread
+	std::vector<float> _snapshot; // UI copy of the played samples, used for visualization
+	unsigned int _snapshotCursor;
 	RtAudio _stream;
 	RtAudio::DeviceInfo _deviceInfo; // Informations about the used audio device
 
-	// Internal audio time used by audio components.
-	// This time is manually incremented in the update method.
-	double _time;
+	// Internal audio time used by audio components, derived from the number of rendered frames
+	// instead of being accumulated so it does not drift. Rebased when the sample rate changes.
+	uint64_t _frameClock;
+	double _clockOrigin;
+
+	// ----------------- RENDER THREAD -----------------
+	std::thread _renderThread;
+	std::atomic<bool> _renderThreadRunning;
+	std::mutex _renderMutex;
+	std::condition_variable _renderCondition; // Notified by the audio callback
+	std::vector<Instrument>* _instruments;
+
+	std::mutex _keyPressedMutex;
+	VoicePool _publishedKeyPressed; // Written by the UI thread
+	VoicePool _renderKeyPressed; // Render thread copy of the published keys, copying a pool never allocates
 	// -------------------------------------------------
 
 	void initBuffer();
@@ -83,9 +115,12 @@ private:
 
 	// [TODO] Make an entity used as an intermediate between sound generation/mixing and sound management (stream open, volume, runtime reconfiguration, ...)
 	static int uploadBuffer(void *outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData);
-	void incrementPhases();
-	void incrementWriteCursor();
 	void copyBufferData(float* data, unsigned int sampleNumber, bool mute = false);
 
+	void renderLoop();
+	void render(unsigned int frames);
+	unsigned int getFramesToRender();
+	unsigned int getMaxRenderFrames() const;
+
 	void stopAndCloseStreamIfExist();
 };
@@ -6,106 +6,138 @@
 
 struct ADSR : public AudioComponent {
 private:
-	struct EnvelopeInfo {
+	struct VoiceEnvelope {
 		sEnvelopeADSR envelope;
-		MidiInfo info;
-		unsigned int id;
-		bool playedThisFrame = false;
+		bool active = false; // Started and not finished yet
+		AudioBlock amplitudes;
+		bool rendered = false; // Amplitudes were rendered by isGateClosed for the current block
+		bool closed = false; // Amplitudes stay at 0 during the current block
 	};
+
+	std::array<VoiceEnvelope, MAX_VOICES> voiceEnvelopes;
+
 public:
 	enum Inputs { input, trigger };
 
-	sEnvelopeADSR reference; // Used to store envelope settings value
-	std::vector<EnvelopeInfo> envelopes;
+	EnvelopeShape shape; // Envelope settings, shared by every voice
 
 	ADSR() : AudioComponent() { inputs.resize(2); componentName = "ADSR"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
-	{
-		if (!inputs.size())
-			return 0.0;
+	// Playing voices follow the new curves from their current position
+	void setControlPoints(const Vec2* controlPoints) { shape.setControlPoints(controlPoints); }
 
-		double inputValue = getInputsValue(input, audioInfos, keyPressed, currentKey);
-		double triggerValue = getInputsValue(trigger, audioInfos, keyPressed, currentKey);
+	void resetVoice(int voice) override
+	{
+		voiceEnvelopes[voice] = {};
+	}
 
-		if (currentKey == 0)
+	void startBlock() override
+	{
+		for (VoiceEnvelope& voiceEnvelope : voiceEnvelopes)
 		{
-			for (auto& e : envelopes)
-				e.playedThisFrame = false;
+			if (voiceEnvelope.envelope.phase == Phase::Inactive)
+				voiceEnvelope.active = false;
 		}
+	}
+
+	// Envelopes driving filters or effects
+	bool supportsControlRate() const override { return true; }
 
-		unsigned int envelopeIndex = keyPressed.size() ? keyPressed[currentKey].keyIndex : triggerValue;
+	bool isVoiceGate() const override { return true; }
+	bool hasVoiceTails() const override { return true; }
 
-		// add new envelopes
-		if (envelopeIndex != 0.0  && triggerValue != 0.0)
+	void getVoiceTails(VoiceMask& tails) const override
+	{
+		for (int voice = 0; voice < MAX_VOICES; voice++)
 		{
-			bool envelopeAlreadyExists = false;
-			for (EnvelopeInfo& envelopeInfo : envelopes)
-			{
-				if (envelopeInfo.id == envelopeIndex)
-				{
-					envelopeAlreadyExists = true;
-					break;
-				}
-			}
-			if (!envelopeAlreadyExists)
-			{
-				EnvelopeInfo envelopeInfo;
-				envelopeInfo.id = envelopeIndex;
-				envelopeInfo.info = {};
-				envelopeInfo.envelope = reference;
-				if (keyPressed.size())
-					envelopeInfo.info = keyPressed[currentKey];
-
-				envelopes.push_back(envelopeInfo);
-			}
+			if (voiceEnvelopes[voice].active)
+				tails.set(voice);
 		}
+	}
+
+	int getGatedInput() const override { return input; }
+
+	// Renders the envelope ahead of processBlock, its input is not needed when it stays at 0 during the block
+	bool isGateClosed(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
+	{
+		VoiceEnvelope& voiceEnvelope = voiceEnvelopes[context.voice];
+		renderAmplitudes(audioInfos, context, voiceEnvelope.amplitudes.data(), frames);
+		voiceEnvelope.rendered = true;
+		voiceEnvelope.closed = Simd::peak(voiceEnvelope.amplitudes.data(), frames) == 0.0f;
+		return voiceEnvelope.closed;
+	}
+
+	// The envelope keeps running, with the same trigger state when the trigger is not a note constant (its branch is skipped too)
+	void skipBlock(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
+	{
+		VoiceEnvelope& voiceEnvelope = voiceEnvelopes[context.voice];
+		AudioBlock discarded;
+		if (inputIsNoteConstant(trigger))
+			renderAmplitudes(audioInfos, context, discarded.data(), frames);
+		else if (voiceEnvelope.active)
+			voiceEnvelope.envelope.render(shape, !context.isReleased() && voiceEnvelope.envelope.noteOn, discarded.data(), frames, context.frameStride);
+	}
 
-		double value = 0.0;
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		VoiceEnvelope& voiceEnvelope = voiceEnvelopes[context.voice];
+		if (!voiceEnvelope.rendered)
+		{
+			renderAmplitudes(audioInfos, context, voiceEnvelope.amplitudes.data(), frames);
+			voiceEnvelope.closed = false;
+		}
+		voiceEnvelope.rendered = false;
 
-		// update envelopes
-		for (EnvelopeInfo& envelopeInfo : envelopes)
+		if (voiceEnvelope.closed)
 		{
-			if (envelopeInfo.id == envelopeIndex && triggerValue != 0.0)
-			{
-				value += inputValue * envelopeInfo.envelope.GetAmplitude(time, true);
-				envelopeInfo.playedThisFrame = true;
-				break;
-			}
+			std::fill(out, out + frames, 0.0f);
+			return;
 		}
 
-		// Play envelope in release
-		if (currentKey == keyPressed.size() - 1 || keyPressed.empty())
+		// Amplitudes are computed first, the input is then scaled in a single pass
+		Simd::multiply(out, getInputsBlock(input, context, frames), voiceEnvelope.amplitudes.data(), frames);
+	}
+
+private:
+	void renderAmplitudes(const AudioInfos& audioInfos, VoiceContext& context, float* amplitudes, int frames)
+	{
+		VoiceEnvelope& voiceEnvelope = voiceEnvelopes[context.voice];
+		// The shape is in frames of the sample rate whatever the stride, so a plan processing the envelope at another rate
+		// does not change it and playing voices go on smoothly
+		if (shape.sampleRate != audioInfos.sampleRate)
+			shape.setSampleRate(audioInfos.sampleRate);
+
+		std::fill(amplitudes, amplitudes + frames, 0.0f);
+
+		// Play envelope in release.
+		// As the note is no longer pressed, its voice is only processed because this envelope (or another one) is still alive.
+		if (context.isReleased())
 		{
-			for (EnvelopeInfo& envelopeInfo : envelopes)
-			{
-				if (!envelopeInfo.playedThisFrame)
-				{
-					// As the note must be extended, it is no longer in the keyPressed vector.
-					// This runs the pipeline from this ADSR node using a new keyPressed vector containing
-					// only the release note as if it were played by the user's midi keyboard.
-					std::vector<MidiInfo> newKeyPressed;
-					if (envelopeInfo.info.keyIndex != 0)
-						newKeyPressed.push_back(envelopeInfo.info);
-					inputValue = getInputsValue(input, audioInfos, newKeyPressed, 0);
-					value += envelopeInfo.envelope.GetAmplitude(time, false) * inputValue;
-				}
-			}
+			if (voiceEnvelope.active)
+				voiceEnvelope.envelope.render(shape, false, amplitudes, frames, context.frameStride);
+			return;
 		}
 
-		// remove finished envelopes
-		for (auto it = envelopes.begin(); it != envelopes.end(); it++)
+		// The trigger starts the envelope, which is released as soon as the trigger falls back to 0.
+		// Frames are rendered by runs of the same trigger state.
+		const float* triggerBlock = getInputsBlock(trigger, context, frames);
+		int i = 0;
+		while (i < frames)
 		{
-			//if (it->phase == Phase::Inactive)
-			if (it->envelope.phase == Phase::Inactive)
+			const bool triggered = triggerBlock[i] != 0.0f;
+			int end = i + 1;
+			while (end < frames && (triggerBlock[end] != 0.0f) == triggered)
+				end++;
+
+			if (triggered && !voiceEnvelope.active)
 			{
-				it = envelopes.erase(it);
-				if (it == envelopes.end())
-					break;
+				voiceEnvelope.envelope = {};
+				voiceEnvelope.active = true;
 			}
-		}
 
-		return value;
+			if (voiceEnvelope.active)
+				voiceEnvelope.envelope.render(shape, triggered, amplitudes + i, end - i, context.frameStride);
+			i = end;
+		}
 	}
 };
-
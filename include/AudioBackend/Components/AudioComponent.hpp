@@ -2,9 +2,135 @@
 
 #include "inc.hpp"
 #include <unordered_map>
+#include <mutex>
+#include <array>
+#include <bitset>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#include <optional>
 #include "Logger.hpp"
+#include "config.hpp"
+#include "AudioBackend/Simd.hpp"
 #include <list>
 
+typedef std::array<float, MAX_BLOCK_FRAMES> AudioBlock;
+// Planar stereo frames: the frames samples of the left channel, followed by the frames samples of the right channel
+typedef std::array<float, 2 * MAX_BLOCK_FRAMES> StereoBlock;
+typedef std::bitset<MAX_VOICES> VoiceMask;
+
+static_assert(MAX_BLOCK_FRAMES % CONTROL_RATE_FRAMES == 0, "Control blocks must not straddle two blocks");
+
+// Output of a component in the plan arena: one block per voice lane, or a single block shared by every lane (stride 0)
+struct BlockSource {
+	const float* data;
+	size_t stride;
+	bool controlRate = false; // Processed at control rate, the block holds one value per control block
+	int channels = 1; // 2 for stereo blocks (see StereoBlock), which are never processed at control rate
+
+	const float* get(int lane) const { return data + lane * stride; }
+
+	// Channel of a block read at audio rate, mono blocks feed both channels
+	const float* getChannel(int lane, int channel, int frames) const { return get(lane) + (channels == 2 ? channel * frames : 0); }
+
+	// Value at frame of a component processed with frameStride
+	float getValue(int lane, int frame, int frameStride) const
+	{
+		return get(lane)[controlRate ? frame * frameStride / CONTROL_RATE_FRAMES : frame * frameStride];
+	}
+
+	// Block as read by a component processed with frameStride, resampled in scratch when processed at another rate
+	const float* read(int lane, int frameStride, float* scratch, int frames, int channel = 0) const
+	{
+		if (controlRate == (frameStride != 1))
+			return getChannel(lane, channel, frames);
+
+		for (int i = 0; i < frames; i++)
+			scratch[i] = getValue(lane, i, frameStride);
+		return scratch;
+	}
+};
+
+// How a component reads one of its inputs
+enum InputRate {
+	AudioRate, // Every frame
+	ControlHeld, // Once per control block, the value is held until the next one
+	ControlLinear, // Once per control block, with a linear ramp in between
+	ControlExponential, // Once per control block, with a constant ratio ramp in between (frequencies, gains). Linear when crossing 0.
+};
+
+/*
+ * Per voice value of a control rate input.
+ * The value read at the start of each control block is reached at its end, so parameter changes do not click (zipper noise).
+ * A new note starts at the value of the input instead of ramping to it.
+*/
+struct ControlSmoother {
+	float value = 0.0f;
+	bool started = false;
+
+	void ramp(InputRate rate, float target, float* out, int frames)
+	{
+		const float previous = value;
+		value = target;
+
+		if (!started || rate == ControlHeld || previous == target)
+		{
+			started = true;
+			std::fill(out, out + frames, target);
+			return;
+		}
+
+		if (rate == ControlExponential && previous > 0.0f && target > 0.0f)
+		{
+			const float ratio = std::pow(target / previous, 1.0f / frames);
+			float level = previous;
+			for (int i = 0; i < frames - 1; i++)
+			{
+				level *= ratio;
+				out[i] = level;
+			}
+			out[frames - 1] = target;
+			return;
+		}
+
+		const float step = (target - previous) / frames;
+		for (int i = 0; i < frames; i++)
+			out[i] = previous + step * (i + 1);
+	}
+};
+
+/*
+ * Per voice silence detection of the components keeping a state (filters, delay lines).
+ * Their state keeps ringing at inaudible levels long after their input stopped. Once both their
+ * input and output have been silent for long enough they sleep: their state is cleared and their
+ * processing skipped, until their input is audible again.
+*/
+struct SilenceDetector {
+	static constexpr size_t SLEEP_FRAMES = SILENT_BLOCKS_BEFORE_SLEEP * MAX_BLOCK_FRAMES;
+
+	size_t silentFrames = 0;
+
+	// memoryFrames is how long an input stays in the component state (delay line length)
+	bool isAsleep(size_t memoryFrames = 0) const { return silentFrames >= std::max(memoryFrames, SLEEP_FRAMES); }
+
+	// The block can be skipped and output as silence
+	bool canSkip(float inputPeak, size_t memoryFrames = 0) const { return inputPeak <= SILENCE_THRESHOLD && isAsleep(memoryFrames); }
+
+	// Called after processing a block, returns true when the component falls asleep and must clear its state
+	bool update(float inputPeak, float outputPeak, int frames, size_t memoryFrames = 0)
+	{
+		if (inputPeak > SILENCE_THRESHOLD || outputPeak > SILENCE_THRESHOLD)
+		{
+			silentFrames = 0;
+			return false;
+		}
+
+		const bool asleep = isAsleep(memoryFrames);
+		silentFrames += frames;
+		return !asleep && isAsleep(memoryFrames);
+	}
+};
+
 struct AudioComponent {
 	AudioComponent() : id(nextId++) { }
 	virtual ~AudioComponent() {};
@@ -15,9 +141,131 @@ struct AudioComponent {
 	static unsigned int nextId;
 	unsigned int id;
 
-	static double time;
+	// Held by the render thread while processing components, and by the UI while editing them.
+	static std::mutex graphMutex;
+
+	// Output blocks of the components plugged on each input, set when the master plan is compiled.
+	// Released voices only read the inputs leading to an envelope (see ExecutionPlan).
+	std::vector<std::vector<BlockSource>> inputSources;
+	std::vector<std::vector<BlockSource>> releaseInputSources;
+
+	// Value of the inputs only fed by constants, so they can be read once per block instead of once per frame
+	std::vector<std::optional<float>> constantInputs;
+	// Inputs only fed by constants and components depending on the note, constant for the whole life of a voice
+	std::vector<bool> noteConstantInputs;
+
+	// Per input and per lane sum of the plugged components, filled by getInputsBlock and getControlBlock.
+	// Lanes do not share their block so the inputs of every voice can be read at once.
+	std::vector<AudioBlock> inputBlocks;
+
+	// Per input and per voice state of the control rate inputs, kept when the plan is compiled again
+	std::vector<ControlSmoother> controlSmoothers;
+
+	// Writes frames (<= MAX_BLOCK_FRAMES) samples in out.
+	// Inputs have already been processed for this voice and are read with getInputsBlock.
+	virtual void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) = 0;
+
+	// Processes several voices, the block of each lane starts MAX_BLOCK_FRAMES per channel after the previous one in out.
+	// Components can override it to process all the voices in a single loop.
+	virtual void processVoices(const AudioInfos& audioInfos, VoiceContext* voices, int voiceCount, float* out, int frames)
+	{
+		for (int i = 0; i < voiceCount; i++)
+			processBlock(audioInfos, voices[i], out + voices[i].lane * MAX_BLOCK_FRAMES * getOutputChannels(), frames);
+	}
+
+	// 2 for components writing stereo blocks (see StereoBlock) in processBlock.
+	// Master and the multipliers scaling them keep both channels, other components read the average of the two.
+	virtual int getOutputChannels() const { return 1; }
+
+	// Called instead of processBlock when the output of the component is not needed for a voice during the block.
+	// Components depending on time must advance as if they had been processed (oscillator phases, envelopes).
+	virtual void skipBlock(const AudioInfos& audioInfos, VoiceContext& context, int frames) {}
 
-	virtual double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) = 0;
+	// Input ignored by the component while its gate is closed (envelopes), -1 if none.
+	// The plan skips the components only feeding it for the voices the gate is closed for.
+	virtual int getGatedInput() const { return -1; }
+
+	// Called for each voice before the components feeding the gated input are processed, the other inputs being ready.
+	// Returns true when the output does not depend on the gated input during the whole block, processBlock must then not read it.
+	virtual bool isGateClosed(const AudioInfos& audioInfos, VoiceContext& context, int frames) { return false; }
+
+	// Called by the plan when it is compiled, with the graph lock held. State depending on the sample rate
+	// (delay lines) must be sized here, the render thread must never allocate it.
+	virtual void prepare(unsigned int sampleRate) {}
+
+	// Called when a voice slot is given to a new note, per voice state must be cleared
+	virtual void resetVoice(int voice) {}
+
+	// Called once per block, before any voice is processed
+	virtual void startBlock() {}
+
+	// True for components whose output only exists while a note is alive (envelopes)
+	virtual bool isVoiceGate() const { return false; }
+
+	// True for components playing every note themselves, on the first lane only (sound fonts).
+	// Their output does not belong to a voice, the gate of a voice must never skip them or their consumers.
+	virtual bool rendersEveryNote() const { return false; }
+
+	// True for components able to keep notes alive after their key is released (envelopes, effect tails)
+	virtual bool hasVoiceTails() const { return false; }
+	// Sets the voice slots this component still makes audible
+	virtual void getVoiceTails(VoiceMask& tails) const {}
+
+	// Control rate inputs must be read with getControlBlock
+	virtual InputRate getInputRate(unsigned int index) const { return AudioRate; }
+
+	// True for components which can be processed once per control block when they only feed control rate inputs.
+	// They must only depend on time through VoiceContext::frameStride (or deltaTime).
+	virtual bool supportsControlRate() const { return false; }
+
+	// True for components whose output only depends on their inputs and on the note of the voice, at any time.
+	// They must not keep any state. The plan evaluates them once per voice when all their inputs are note constants.
+	virtual bool dependsOnlyOnNote() const { return false; }
+
+	// Used by the plan to fold constant subtrees: returns true and sets value if the output
+	// does not depend on time or voice given the constant inputs (empty optional for other inputs).
+	virtual bool getConstantOutput(const std::vector<std::optional<float>>& inputValues, float& value) const { return false; }
+
+	bool inputIsConstant(const unsigned int& index) const
+	{
+		return index < constantInputs.size() && constantInputs[index].has_value();
+	}
+
+	// The input block of a voice holds the same value on every frame, until the voice is reset
+	bool inputIsNoteConstant(const unsigned int& index) const
+	{
+		return inputIsConstant(index) || (index < noteConstantInputs.size() && noteConstantInputs[index]);
+	}
+
+	// Called by the plan when a voice slot is given to a new note
+	void resetControls(int voice)
+	{
+		for (size_t index = 0; index * MAX_VOICES < controlSmoothers.size(); index++)
+			controlSmoothers[index * MAX_VOICES + voice] = {};
+	}
+
+	/*
+	 * Fast path of a constant control rate input, which can then be read from constantInputs.
+	 * Returns false while a voice is still ramping toward a new value, the input must then be read with getControlBlock.
+	 * The smoothers of the voices are set to the constant, so they ramp from it when it is changed.
+	*/
+	bool isControlSettled(const unsigned int& index, const VoiceContext* voices, int voiceCount)
+	{
+		if (!inputIsConstant(index))
+			return false;
+
+		const float value = *constantInputs[index];
+		for (int i = 0; i < voiceCount; i++)
+		{
+			const ControlSmoother& smoother = getControlSmoother(index, voices[i].voice);
+			if (smoother.started && smoother.value != value)
+				return false;
+		}
+
+		for (int i = 0; i < voiceCount; i++)
+			getControlSmoother(index, voices[i].voice) = { value, true };
+		return true;
+	}
 
 	Components getInputs() const
 	{
@@ -69,20 +317,67 @@ struct AudioComponent {
 		return deleted;
 	}
 
-	virtual double getInputsValue(const unsigned int& index, const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0)
+	// Sum of the components plugged on input index, the returned block is valid until the next call with the same index and lane
+	const float* getInputsBlock(const unsigned int& index, VoiceContext& context, int frames)
+	{
+		static const AudioBlock silence = {};
+
+		if (inputs.size() <= index)
+		{
+			Logger::log("AudioComponent", Error) << "Out of bound index in getInputsBlock method" << std::endl;
+			exit(1);
+		}
+
+		std::vector<std::vector<BlockSource>>& sources = context.isReleased() ? releaseInputSources : inputSources;
+		if (sources.size() <= index || sources[index].empty())
+			return silence.data();
+
+		// No sum needed, read the plugged component output directly
+		const std::vector<BlockSource>& inputSource = sources[index];
+		if (inputSource.size() == 1 && inputSource[0].controlRate == (context.frameStride != 1))
+			return inputSource[0].getChannel(context.lane, 0, frames);
+
+		float* block = getScratchBlock(index, context.lane);
+		if (inputSource.size() == 1)
+			return inputSource[0].read(context.lane, context.frameStride, block, frames);
+
+		AudioBlock resampled;
+		const float* first = inputSource[0].read(context.lane, context.frameStride, resampled.data(), frames);
+		std::copy(first, first + frames, block);
+		for (size_t i = 1; i < inputSource.size(); i++)
+			Simd::add(block, inputSource[i].read(context.lane, context.frameStride, resampled.data(), frames), frames);
+		return block;
+	}
+
+	// Sum of the components plugged on the control rate input index, read once per control block and smoothed in between.
+	// The returned block is valid until the next call with the same index and lane.
+	const float* getControlBlock(const unsigned int& index, VoiceContext& context, int frames)
 	{
 		if (inputs.size() <= index)
 		{
-			Logger::log("AudioComponent", Error) << "Out of bound index in getInputValue method" << std::endl;
+			Logger::log("AudioComponent", Error) << "Out of bound index in getControlBlock method" << std::endl;
 			exit(1);
 		}
 
-		ComponentInput& input = inputs[index];
+		std::vector<std::vector<BlockSource>>& sources = context.isReleased() ? releaseInputSources : inputSources;
+		const std::vector<BlockSource>* inputSource = index < sources.size() ? &sources[index] : nullptr;
+		ControlSmoother& smoother = getControlSmoother(index, context.voice);
+		const InputRate rate = getInputRate(index);
+		float* block = getScratchBlock(index, context.lane);
 
-		double value = 0.0;
-		for (AudioComponent* component : input)
-			value += component->process(audioInfos, keyPressed, currentKey);
-		return value;
+		// Components processed at control rate read a new value every frame
+		const int controlBlockFrames = CONTROL_RATE_FRAMES / context.frameStride;
+		for (int start = 0; start < frames; start += controlBlockFrames)
+		{
+			float target = 0.0f;
+			if (inputSource)
+			{
+				for (const BlockSource& source : *inputSource)
+					target += source.getValue(context.lane, start, context.frameStride);
+			}
+			smoother.ramp(rate, target, block + start, std::min(frames - start, controlBlockFrames));
+		}
+		return block;
 	}
 
 	bool idIsDirectChild(const unsigned int id) const
@@ -111,6 +406,20 @@ struct AudioComponent {
 		}
 	}
 
+	// Sized by the plan when it is compiled, only for the control rate inputs
+	ControlSmoother& getControlSmoother(const unsigned int& index, int voice)
+	{
+		assert(controlSmoothers.size() == inputs.size() * MAX_VOICES && "Control smoothers are sized when the plan is compiled");
+		return controlSmoothers[index * MAX_VOICES + voice];
+	}
+
+	// Sized by the plan when it is compiled, only for the summed, resampled and control rate inputs
+	float* getScratchBlock(const unsigned int& index, int lane)
+	{
+		assert(inputBlocks.size() == inputs.size() * MAX_VOICES && "Input blocks are sized when the plan is compiled");
+		return inputBlocks[index * MAX_VOICES + lane].data();
+	}
+
 	AudioComponent* getAudioComponent(const unsigned int id)
 	{
 		if (this->id == id)
@@ -1,46 +1,147 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include "AudioComponent.hpp"
 #include "audio_backend.hpp"
 
 struct CombFilter : public AudioComponent {
+private:
+	// Keeps a voice alive while its delay line is still audible
+	struct VoiceTail {
+		SilenceDetector silenceDetector; // Asleep once the whole delay line is silent
+		bool processed = false;
+		bool ringing = false;
+	};
+
+	std::array<VoiceTail, MAX_VOICES> tails;
+
+public:
 	enum Input { input, delaySamples, feedback };
 
-	std::vector<double> delayBuffer;
-	int bufferIndex = 0;
+	// Per voice delay line of maxDelayLength samples, allocated by prepare so changing the delay never allocates
+	// on the render thread. Only the first delayLengths[voice] samples are used.
+	std::array<std::vector<float>, MAX_VOICES> delayBuffers;
+	std::array<int, MAX_VOICES> delayLengths = {};
+	std::array<int, MAX_VOICES> bufferIndexes = {};
+	int maxDelayLength = 0;
+	bool showDelayWarning = true;
 
 	CombFilter() : AudioComponent() { inputs.resize(3); componentName = "CombFilter"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	void prepare(unsigned int sampleRate) override
 	{
-		const int delaySamplesValue = static_cast<int>(getInputsValue(delaySamples, audioInfos, keyPressed, currentKey));
-		const double feedbackValue = std::clamp(getInputsValue(feedback, audioInfos, keyPressed, currentKey), 0.0, 1.0);
-		const double inputValue = getInputsValue(input, audioInfos, keyPressed, currentKey);
+		const int length = static_cast<int>(std::ceil(COMB_FILTER_MAX_DELAY_SECONDS * sampleRate));
+		if (length == maxDelayLength)
+			return;
+
+		maxDelayLength = length;
+		for (int voice = 0; voice < MAX_VOICES; voice++)
+		{
+			delayBuffers[voice].assign(maxDelayLength, 0.0f);
+			delayLengths[voice] = 0;
+			resetVoice(voice);
+		}
+	}
 
-		// Resize buffer on delaySamplesValue change
-		if (delaySamplesValue > 0 && delaySamplesValue != delayBuffer.size())
+	// The delay length only changes once per control block
+	InputRate getInputRate(unsigned int index) const override
+	{
+		switch (index)
 		{
-			delayBuffer.resize(delaySamplesValue);
-			if (bufferIndex >= delayBuffer.size())
-				bufferIndex = 0;
+			case delaySamples: return ControlHeld;
+			case feedback: return ControlLinear;
+			default: return AudioRate;
 		}
+	}
 
-		if (delayBuffer.empty())
-			return 0.0;
+	void resetVoice(int voice) override
+	{
+		std::fill(delayBuffers[voice].begin(), delayBuffers[voice].begin() + delayLengths[voice], 0.0f);
+		bufferIndexes[voice] = 0;
+		tails[voice] = {};
+	}
+
+	void startBlock() override
+	{
+		for (int voice = 0; voice < MAX_VOICES; voice++)
+		{
+			VoiceTail& tail = tails[voice];
+			tail.ringing = tail.processed && !tail.silenceDetector.isAsleep(delayLengths[voice]);
+			tail.processed = false;
+		}
+	}
 
-		if (currentKey == 0) // only increment bufferIndex on the first note (playing multiple notes must not increase index)
-			bufferIndex = (bufferIndex + 1) % delayBuffer.size();
+	bool hasVoiceTails() const override { return true; }
 
-		double output = inputValue;
-		if (currentKey == 0)
+	void getVoiceTails(VoiceMask& voiceTails) const override
+	{
+		for (int voice = 0; voice < MAX_VOICES; voice++)
 		{
-			output += feedbackValue * delayBuffer[bufferIndex]; // Add stored sound to the first note
-			delayBuffer[bufferIndex] = output; // Replace stored sound with current sound
+			if (tails[voice].ringing)
+				voiceTails.set(voice);
+		}
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		const float* delaySamplesBlock = getControlBlock(delaySamples, context, frames);
+		const float* feedbackBlock = getControlBlock(feedback, context, frames);
+		const float* inputBlock = getInputsBlock(input, context, frames);
+		const float inputPeak = Simd::peak(inputBlock, frames);
+
+		std::vector<float>& delayBuffer = delayBuffers[context.voice];
+		int& delayLength = delayLengths[context.voice];
+		int& bufferIndex = bufferIndexes[context.voice];
+		VoiceTail& tail = tails[context.voice];
+		tail.processed = true;
+
+		if (tail.silenceDetector.canSkip(inputPeak, delayLength))
+		{
+			std::fill(out, out + frames, 0.0f);
+			return;
+		}
+
+		for (int i = 0; i < frames; i++)
+		{
+			int delaySamplesValue = static_cast<int>(delaySamplesBlock[i]);
+			if (delaySamplesValue > maxDelayLength)
+			{
+				if (showDelayWarning)
+				{
+					showDelayWarning = false;
+					Logger::log("CombFilter", Warning) << "Delay of " << delaySamplesValue << " samples clamped to "
+						<< maxDelayLength << " (" << COMB_FILTER_MAX_DELAY_SECONDS << " s)." << std::endl;
+				}
+				delaySamplesValue = maxDelayLength;
+			}
+			const float feedbackValue = std::clamp(feedbackBlock[i], 0.0f, 1.0f);
+
+			// Samples added to a longer delay line start silent
+			if (delaySamplesValue > 0 && delaySamplesValue != delayLength)
+			{
+				if (delaySamplesValue > delayLength)
+					std::fill(delayBuffer.begin() + delayLength, delayBuffer.begin() + delaySamplesValue, 0.0f);
+				delayLength = delaySamplesValue;
+				if (bufferIndex >= delayLength)
+					bufferIndex = 0;
+			}
+
+			if (delayLength == 0)
+			{
+				out[i] = 0.0f;
+				continue;
+			}
+
+			bufferIndex = (bufferIndex + 1) % delayLength;
+
+			const float output = inputBlock[i] + feedbackValue * delayBuffer[bufferIndex];
+			delayBuffer[bufferIndex] = output;
+
+			out[i] = output;
 		}
-		else
-			delayBuffer[bufferIndex] += inputValue; // Add other notes sound to the buffer
 
-		return output;
+		if (tail.silenceDetector.update(inputPeak, Simd::peak(out, frames), frames, delayLength))
+			std::fill(delayBuffer.begin(), delayBuffer.begin() + delayLength, 0.0f);
 	}
 };
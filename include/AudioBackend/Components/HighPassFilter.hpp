@@ -6,21 +6,129 @@
 struct HighPassFilter : public AudioComponent {
 	enum Inputs { input, cutoff, resonance };
 
-	double low = 0.0;
-	double band = 0.0;
+	// Per voice filter state
+	std::array<double, MAX_VOICES> lowStates = {};
+	std::array<double, MAX_VOICES> bandStates = {};
+	std::array<SilenceDetector, MAX_VOICES> silenceDetectors;
 
 	HighPassFilter() : AudioComponent() { inputs.resize(3); componentName = "HighPassFilter"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	InputRate getInputRate(unsigned int index) const override
 	{
-		const double cutoffValue = std::clamp(getInputsValue(cutoff, audioInfos, keyPressed, currentKey), 0.01, 0.99);
-		const double resonanceValue = std::clamp(getInputsValue(resonance, audioInfos, keyPressed, currentKey), 0.00, 0.95);
-		const double inputValue = getInputsValue(input, audioInfos, keyPressed, currentKey);
+		switch (index)
+		{
+			case cutoff: return ControlExponential;
+			case resonance: return ControlLinear;
+			default: return AudioRate;
+		}
+	}
+
+	void resetVoice(int voice) override
+	{
+		lowStates[voice] = 0.0;
+		bandStates[voice] = 0.0;
+		silenceDetectors[voice] = {};
+	}
+
+	// Parameters shared by every voice let the voices be filtered together, one per vector lane
+	void processVoices(const AudioInfos& audioInfos, VoiceContext* voices, int voiceCount, float* out, int frames) override
+	{
+		if (!isControlSettled(cutoff, voices, voiceCount) || !isControlSettled(resonance, voices, voiceCount))
+		{
+			AudioComponent::processVoices(audioInfos, voices, voiceCount, out, frames);
+			return;
+		}
+
+		float* outputs[MAX_VOICES];
+		for (int i = 0; i < voiceCount; i++)
+			outputs[i] = out + voices[i].lane * MAX_BLOCK_FRAMES;
+		filterVoices(voices, voiceCount, outputs, frames);
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		if (isControlSettled(cutoff, &context, 1) && isControlSettled(resonance, &context, 1))
+		{
+			filterVoices(&context, 1, &out, frames);
+			return;
+		}
+
+		const float* inputBlock = getInputsBlock(input, context, frames);
+		const float inputPeak = Simd::peak(inputBlock, frames);
+
+		SilenceDetector& silenceDetector = silenceDetectors[context.voice];
+		if (silenceDetector.canSkip(inputPeak))
+		{
+			std::fill(out, out + frames, 0.0f);
+			return;
+		}
+
+		double low = lowStates[context.voice];
+		double band = bandStates[context.voice];
+
+		const float* cutoffBlock = getControlBlock(cutoff, context, frames);
+		const float* resonanceBlock = getControlBlock(resonance, context, frames);
+
+		for (int i = 0; i < frames; i++)
+		{
+			const double cutoffValue = std::clamp(static_cast<double>(cutoffBlock[i]), 0.01, 0.99);
+			const double resonanceValue = std::clamp(static_cast<double>(resonanceBlock[i]), 0.00, 0.95);
+
+			const double high = inputBlock[i] - low - (1.0 - resonanceValue) * band;
+			band += cutoffValue * high;
+			low += cutoffValue * band;
+
+			out[i] = high;
+		}
+
+		if (silenceDetector.update(inputPeak, Simd::peak(out, frames), frames))
+			low = band = 0.0;
+
+		lowStates[context.voice] = low;
+		bandStates[context.voice] = band;
+	}
+
+private:
+	void filterVoices(VoiceContext* voices, int voiceCount, float* const* outputs, int frames)
+	{
+		// Clamp parameters once as they are constant
+		const float cutoffValue = std::clamp(*constantInputs[cutoff], 0.01f, 0.99f);
+		const float damping = 1.0f - std::clamp(*constantInputs[resonance], 0.00f, 0.95f);
+
+		// Sleeping voices with a silent input output silence, the others are filtered together
+		const float* voiceInputs[MAX_VOICES];
+		float* voiceOutputs[MAX_VOICES];
+		float inputPeaks[MAX_VOICES], lows[MAX_VOICES], bands[MAX_VOICES];
+		int awakeVoices[MAX_VOICES];
+		int awakeCount = 0;
+		for (int i = 0; i < voiceCount; i++)
+		{
+			const float* inputBlock = getInputsBlock(input, voices[i], frames);
+			const float inputPeak = Simd::peak(inputBlock, frames);
+			if (silenceDetectors[voices[i].voice].canSkip(inputPeak))
+			{
+				std::fill(outputs[i], outputs[i] + frames, 0.0f);
+				continue;
+			}
+
+			voiceInputs[awakeCount] = inputBlock;
+			voiceOutputs[awakeCount] = outputs[i];
+			inputPeaks[awakeCount] = inputPeak;
+			lows[awakeCount] = lowStates[voices[i].voice];
+			bands[awakeCount] = bandStates[voices[i].voice];
+			awakeVoices[awakeCount++] = voices[i].voice;
+		}
+
+		Simd::stateVariableFilter(voiceInputs, voiceOutputs, lows, bands, awakeCount, cutoffValue, damping, true, frames);
 
-		const double high = inputValue - low - (1.0 - resonanceValue) * band;
-		band += cutoffValue * high;
-		low += cutoffValue * band;
+		for (int i = 0; i < awakeCount; i++)
+		{
+			const int voice = awakeVoices[i];
+			if (silenceDetectors[voice].update(inputPeaks[i], Simd::peak(voiceOutputs[i], frames), frames))
+				lows[i] = bands[i] = 0.0f;
 
-		return high;
+			lowStates[voice] = lows[i];
+			bandStates[voice] = bands[i];
+		}
 	}
 };
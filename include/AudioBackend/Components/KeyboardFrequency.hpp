@@ -2,36 +2,30 @@
 
 #include "AudioComponent.hpp"
 #include "audio_backend.hpp"
+#include "AudioBackend/Tuning.hpp"
 
 struct KeyboardFrequency : public AudioComponent {
 	static unsigned int keyIndex;
+	// Shared by every instrument, only written by the UI while holding graphMutex
+	static Tuning::Table frequencies;
+	// Incremented each time frequencies change, values cached per note are then computed again
+	inline static unsigned int frequenciesVersion = 0;
 
 	KeyboardFrequency() : AudioComponent() { componentName = "KeyboardFrequency"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	// Must be called with the graph lock held
+	static void setFrequencies(const Tuning::Table& table)
 	{
-		if (!keyPressed.size())
-			return 0.0;
-
-		return pianoKeyFrequency(keyPressed[currentKey].keyIndex);
+		frequencies = table;
+		frequenciesVersion++;
 	}
 
-	double pianoKeyFrequency(int keyId)
-	{
-		// Frequency of key A4 (A440) is 440 Hz
-		double A4Frequency = 440.0;
-
-		// Number of keys from A4 to the given key
-		int keysDifference = keyId - 69;
-
-		// Frequency multiplier for each semitone
-		double semitoneRatio = pow(2.0, 1.0/12.0);
+	bool supportsControlRate() const override { return true; }
+	bool dependsOnlyOnNote() const override { return true; }
 
-		// Calculate the frequency of the given key
-		double frequency = A4Frequency * pow(semitoneRatio, keysDifference);
-
-		//std::cout << keyId << " " << frequency << std::endl;
-
-		return frequency;
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		const float frequency = context.key ? frequencies[context.key->keyIndex & (NOTE_COUNT - 1)] : 0.0f;
+		std::fill(out, out + frames, frequency);
 	}
 };
@@ -2,16 +2,31 @@
 
 #include <unordered_set>
 #include "AudioComponent.hpp"
+#include "AudioBackend/ExecutionPlan.hpp"
 #include "audio_backend.hpp"
 
 struct Master : public AudioComponent {
 private:
 	bool showWarning = true;
+	ExecutionPlan plan;
+	std::vector<VoiceContext> voices; // Voices processed together, reserved for MAX_VOICES
+
+	// Notes bound to the voice slots of the components, released notes stay while they have a tail
+	VoicePool voicePool;
+
+	int voiceLimit = DEFAULT_VOICE_LIMIT;
+	unsigned long stolenVoiceCount = 0;
+	VoiceMask fadingVoices; // Stolen voices, played one last block with a fade out
+	std::bitset<NOTE_COUNT> stolenNotes; // Held notes whose voice was stolen, not played again before their key is released
 
 public:
 	enum Inputs { input };
 
-	Master() : AudioComponent() { inputs.resize(1); componentName = "Master"; }
+	Master() : AudioComponent()
+	{
+		inputs.resize(1); componentName = "Master";
+		voices.reserve(MAX_VOICES);
+	}
 
 	virtual ~Master()
 	{
@@ -38,8 +53,13 @@ public:
 		}
 	}
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	// Mixes the voices in a stereo block
+	int getOutputChannels() const override { return 2; }
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
 	{
+		std::fill(out, out + 2 * frames, 0.0f);
+
 		if (!inputs.size())
 		{
 			if (showWarning)
@@ -47,24 +67,83 @@ public:
 				showWarning = false;
 				Logger::log("Audio", Warning) << "No input plugged to master." << std::endl;
 			}
-			return 0;
+			return;
 		}
 
 		showWarning = true;
 
-		double value = 0.0;
+		plan.startBlock();
 
+		// A single voice without key is played when nothing is pressed
+		const bool idle = !context.keyPressed.hasPressedVoices();
 
-		for (AudioComponent* input : inputs[input])
+		// Notes released since the previous block
+		for (int slot = 0; slot < MAX_VOICES; slot++)
 		{
-			int i = 0;
-			do
-			{
-				value += input->process(audioInfos, keyPressed, i);
-			} while (++i < keyPressed.size());
+			const VoicePool::Voice& voice = voicePool[slot];
+			const int note = voice.info.keyIndex;
+			if (voice.phase != VoicePool::Pressed || (note == 0 && idle) || context.keyPressed.find(note) != -1)
+				continue;
+
+			if (slot == 0) // The voice without key has no release, it stops as soon as a key is pressed
+				voicePool.free(slot);
+			else
+				voicePool.release(slot);
+		}
+		for (int note = 0; note < NOTE_COUNT; note++)
+		{
+			if (stolenNotes[note] && context.keyPressed.find(note) == -1)
+				stolenNotes.reset(note);
+		}
+
+		stealVoices(context.keyPressed);
+
+		voices.clear();
+		if (idle)
+			pressVoice({ 0, 0, false }, context);
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			const VoicePool::Voice& key = context.keyPressed[slot];
+			if (key.phase == VoicePool::Pressed && (!isStolen(key.info.keyIndex) || isFading(key.info.keyIndex)))
+				pressVoice(key.info, context);
+		}
+		plan.run(audioInfos, voices.data(), voices.size(), out, frames);
+
+		// Released notes whose envelopes or effect tails are not finished yet and still audible, the others free their slot.
+		// Long releases and feedback tails are stopped once inaudible instead of running until they reach zero.
+		VoiceMask tails;
+		plan.getVoiceTails(tails);
+		voices.clear();
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			if (voicePool[slot].phase != VoicePool::Released)
+				continue;
+
+			if (tails[slot] && !plan.isVoiceSilent(slot))
+				voices.push_back({ context.keyPressed, &voicePool[slot].info, slot, static_cast<int>(voices.size()), true, context.time, context.deltaTime, fadingVoices[slot] });
+			else
+				voicePool.free(slot);
 		}
+		plan.run(audioInfos, voices.data(), voices.size(), out, frames);
+
+		// Stolen voices are faded out, their slots can be given to the new notes
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			if (fadingVoices[slot])
+				voicePool.free(slot);
+		}
+		fadingVoices.reset();
+	}
 
-		return value;
+	// Must be called with the graph lock held
+	void setVoiceLimit(int limit) { voiceLimit = std::clamp(limit, 1, MAX_VOICES - 1); }
+	int getVoiceLimit() const { return voiceLimit; }
+	unsigned long getStolenVoiceCount() const { return stolenVoiceCount; }
+
+	// Must be called with the graph lock held each time components are linked or unlinked, or the sample rate changes
+	void compile(unsigned int sampleRate)
+	{
+		plan.compile(this, sampleRate);
 	}
 
 	void deleteComponentAndInputs(AudioComponent* component)
@@ -86,4 +165,94 @@ public:
 
 		removeComponentFromBranch(component, true);
 	}
+
+private:
+	// Binds the note to a voice slot, reset when the note was not already playing, and adds it to the processed voices.
+	// When no slot is free (stolen voices are still fading out), the note starts on the next block.
+	void pressVoice(const MidiInfo& key, const VoiceContext& context)
+	{
+		const bool playing = voicePool.find(key.keyIndex) != -1;
+		const int slot = voicePool.press(key);
+		if (slot == -1)
+			return;
+
+		if (!playing)
+			plan.resetVoice(slot);
+
+		const MidiInfo* info = key.keyIndex != 0 ? &voicePool[slot].info : nullptr;
+		voices.push_back({ context.keyPressed, info, slot, static_cast<int>(voices.size()), false, context.time, context.deltaTime, fadingVoices[slot] });
+	}
+
+	bool isStolen(int note) const
+	{
+		return note >= 0 && note < NOTE_COUNT && stolenNotes[note];
+	}
+
+	bool isFading(int note) const
+	{
+		const int slot = voicePool.find(note);
+		return slot != -1 && fadingVoices[slot];
+	}
+
+	// Frees enough voices for the notes starting in this block to fit in the voice limit
+	void stealVoices(const VoicePool& keyPressed)
+	{
+		int activeVoices = 0;
+		for (int slot = 1; slot < MAX_VOICES; slot++)
+		{
+			if (voicePool[slot].phase != VoicePool::Free)
+				activeVoices++;
+		}
+
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			const int note = keyPressed[slot].info.keyIndex;
+			if (keyPressed[slot].phase == VoicePool::Pressed && note != 0 && !isStolen(note) && voicePool.find(note) == -1)
+				activeVoices++;
+		}
+
+		for (int excess = activeVoices - voiceLimit; excess > 0; excess--)
+		{
+			const int victim = findVictim(keyPressed);
+			if (victim == -1)
+				break;
+
+			fadingVoices.set(victim);
+			stolenVoiceCount++;
+
+			const int note = voicePool[victim].info.keyIndex;
+			if (note < NOTE_COUNT && keyPressed.find(note) != -1)
+				stolenNotes.set(note);
+		}
+	}
+
+	// Released voices first, then the quietest, then the oldest
+	int findVictim(const VoicePool& keyPressed) const
+	{
+		int victim = -1;
+		for (int slot = 1; slot < MAX_VOICES; slot++)
+		{
+			const VoicePool::Voice& voice = voicePool[slot];
+			if (voice.phase == VoicePool::Free || fadingVoices[slot])
+				continue;
+
+			if (victim == -1 || isLessImportant(keyPressed, slot, victim))
+				victim = slot;
+		}
+		return victim;
+	}
+
+	bool isLessImportant(const VoicePool& keyPressed, int slot, int other) const
+	{
+		// Released notes pressed again in this block are not released anymore
+		const bool released = keyPressed.find(voicePool[slot].info.keyIndex) == -1;
+		const bool otherReleased = keyPressed.find(voicePool[other].info.keyIndex) == -1;
+		if (released != otherReleased)
+			return released;
+
+		if (plan.getVoiceLevel(slot) != plan.getVoiceLevel(other))
+			return plan.getVoiceLevel(slot) < plan.getVoiceLevel(other);
+
+		return voicePool[slot].age < voicePool[other].age;
+	}
 };
@@ -6,12 +6,84 @@
 struct Multiplier : public AudioComponent {
 	enum Inputs { inputA, inputB };
 
+	/*
+	 * Set by the plan when the product can be computed without summing inputs:
+	 * constant inputs are folded in gain and chained multipliers are merged in factors.
+	*/
+	bool factorized = false;
+	float gain = 1.0f;
+	std::vector<BlockSource> factors;
+	int channels = 1; // Stereo when one of the factors is, the others then scale both channels
+	// Factors leading to an envelope, the other factors are not processed while one of them is silent
+	std::vector<BlockSource> gates;
+	VoiceMask closedVoices;
+
 	Multiplier() : AudioComponent() { inputs.resize(2); componentName = "Multiplier"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	int getOutputChannels() const override { return factorized ? channels : 1; }
+	bool supportsControlRate() const override { return true; }
+	bool dependsOnlyOnNote() const override { return true; }
+
+	bool isGateClosed(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
+	{
+		AudioBlock resampled;
+		bool closed = false;
+		for (const BlockSource& gate : gates)
+			closed = closed || Simd::peak(gate.read(context.lane, context.frameStride, resampled.data(), frames), frames) == 0.0f;
+		closedVoices.set(context.voice, closed);
+		return closed;
+	}
+
+	bool getConstantOutput(const std::vector<std::optional<float>>& inputValues, float& value) const override
+	{
+		for (const std::optional<float>& inputValue : inputValues)
+		{
+			if (inputValue && *inputValue == 0.0f)
+			{
+				value = 0.0f;
+				return true;
+			}
+		}
+
+		if (!inputValues[inputA] || !inputValues[inputB])
+			return false;
+
+		value = *inputValues[inputA] * *inputValues[inputB];
+		return true;
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		if (factorized)
+		{
+			if (!gates.empty() && closedVoices[context.voice])
+			{
+				std::fill(out, out + channels * frames, 0.0f);
+				return;
+			}
+			for (int channel = 0; channel < channels; channel++)
+				processFactors(context, out + channel * frames, frames, channel);
+			return;
+		}
+
+		const float* blockA = getInputsBlock(inputA, context, frames);
+		const float* blockB = getInputsBlock(inputB, context, frames);
+
+		Simd::multiply(out, blockA, blockB, frames);
+	}
+
+private:
+	void processFactors(const VoiceContext& context, float* out, int frames, int channel)
 	{
-		double valueA = getInputsValue(inputA, audioInfos, keyPressed, currentKey);
-		double valueB = getInputsValue(inputB, audioInfos, keyPressed, currentKey);
-		return valueA * valueB;
+		if (factors.empty())
+		{
+			std::fill(out, out + frames, gain);
+			return;
+		}
+
+		AudioBlock resampled;
+		Simd::scale(out, factors[0].read(context.lane, context.frameStride, resampled.data(), frames, channel), gain, frames);
+		for (size_t j = 1; j < factors.size(); j++)
+			Simd::multiply(out, out, factors[j].read(context.lane, context.frameStride, resampled.data(), frames, channel), frames);
 	}
 };
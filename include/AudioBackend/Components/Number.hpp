@@ -7,8 +7,14 @@ struct Number : public AudioComponent {
 
 	Number() : AudioComponent() { componentName = "Number"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	bool getConstantOutput(const std::vector<std::optional<float>>& inputValues, float& value) const override
 	{
-		return number;
+		value = number;
+		return true;
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		std::fill(out, out + frames, number);
 	}
 };
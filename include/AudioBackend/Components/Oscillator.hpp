@@ -1,71 +1,236 @@
 #pragma once
 
 #include <cstdlib>
+#include <cmath>
+#include <cstdint>
 #include "AudioComponent.hpp"
 #include "audio_backend.hpp"
+#include "AudioBackend/Wavetable.hpp"
 
-enum OscType { Sine, Square, Triangle, Saw_Dig, WhiteNoise, PinkNoise, BrownianNoise };
+// New types are appended, instruments store the type index
+enum OscType { Sine, Square, Triangle, Saw_Dig, WhiteNoise, PinkNoise, BrownianNoise, WavetableSquare, WavetableTriangle, WavetableSaw,
+	PolyBlepSquare, PolyBlepTriangle, PolyBlepSaw };
 
 struct Oscillator : public AudioComponent {
 	enum Inputs { frequency, phase };
 	OscType type;
 
-	Oscillator() : AudioComponent() { inputs.resize(2); componentName = "Oscillator"; }
-	double pink_b0 = 0, pink_b1 = 0, pink_b2 = 0;
-	double brownLast = 0.0;
+	Oscillator() : AudioComponent() { inputs.resize(2); componentName = "Oscillator"; seedNoise(id); }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	// LFOs driving filters or effects
+	bool supportsControlRate() const override { return true; }
+
+	/*
+	 * Per voice phase accumulators, advanced by the frequency of each frame.
+	 * One cycle spans the whole uint32_t range so the phase wraps around by itself: precision and cost
+	 * do not depend on how long the voice has been playing, and frequency changes do not make it jump.
+	*/
+	static constexpr double PHASE_RANGE = 4294967296.0;
+	std::array<uint32_t, MAX_VOICES> phaseAccumulators = {};
+	std::array<uint32_t, MAX_VOICES> lastIncrements = {}; // Used to advance the phase of skipped blocks
+
+	/*
+	 * Per voice noise generators, they do not share any state with other voices or oscillators.
+	 * Generators are not reset with the voice so successive notes of a slot do not repeat the same noise.
+	*/
+	std::array<std::array<uint32_t, Simd::NOISE_LANES>, MAX_VOICES> noiseGenerators;
+	std::array<std::array<float, Simd::PINK_STATE_SIZE>, MAX_VOICES> pinkStates = {};
+	std::array<float, MAX_VOICES> brownStates = {};
+
+	void resetVoice(int voice) override
+	{
+		phaseAccumulators[voice] = 0;
+		lastIncrements[voice] = 0;
+		pinkStates[voice] = {};
+		brownStates[voice] = 0.0f;
+	}
+
+	// Noise only depends on the seed and on the played notes, renders using the same seed are bit-identical.
+	// Oscillators are seeded with their id when created.
+	void seedNoise(uint32_t seed)
+	{
+		for (int voice = 0; voice < MAX_VOICES; voice++)
+		{
+			for (int lane = 0; lane < Simd::NOISE_LANES; lane++)
+			{
+				// Murmur3 finalizer, xorshift needs a non zero state
+				uint32_t state = seed * 0x9e3779b9u + voice * Simd::NOISE_LANES + lane + 1;
+				state = (state ^ (state >> 16)) * 0x85ebca6bu;
+				state = (state ^ (state >> 13)) * 0xc2b2ae35u;
+				state ^= state >> 16;
+				noiseGenerators[voice][lane] = state ? state : 1;
+			}
+		}
+	}
+
+	// Phase keeps advancing, at the last frequency when it is not a note constant (its branch is skipped too)
+	void skipBlock(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
+	{
+		uint32_t increment = lastIncrements[context.voice];
+		if (inputIsNoteConstant(frequency))
+			increment = toPhase(getInputsBlock(frequency, context, frames)[0] * (static_cast<double>(context.frameStride) / audioInfos.sampleRate));
+		phaseAccumulators[context.voice] += increment * static_cast<uint32_t>(frames);
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
 	{
 		if (inputs[frequency].size() <= 0)
-			return 0.0;
+		{
+			std::fill(out, out + frames, 0.0f);
+			return;
+		}
+
+		if (type == WhiteNoise || type == PinkNoise || type == BrownianNoise)
+		{
+			renderNoise(out, context.voice, frames);
+			return;
+		}
+
+		const float* frequencyBlock = getInputsBlock(frequency, context, frames);
+		const float* phaseBlock = getInputsBlock(phase, context, frames);
+
+		// The phase input is in half cycles (1 is a phase shift of pi)
+		const double cyclesPerHertz = static_cast<double>(context.frameStride) / audioInfos.sampleRate;
+		const bool constantPhase = inputIsConstant(phase);
+		const uint32_t phaseOffset = constantPhase ? toPhase(*constantInputs[phase] * 0.5) : 0;
+		// Frequency of a note (keyboard frequency, transposed or not)
+		const bool constantFrequency = inputIsNoteConstant(frequency);
+		const uint32_t frequencyIncrement = constantFrequency ? toPhase(frequencyBlock[0] * cyclesPerHertz) : 0;
+
+		uint32_t& accumulator = phaseAccumulators[context.voice];
+		std::array<uint32_t, MAX_BLOCK_FRAMES> phases;
+		std::array<uint32_t, MAX_BLOCK_FRAMES> increments; // Absolute values, negative frequencies play the waveform backward
+		uint32_t maxIncrement = 0;
+		uint32_t lastIncrement = 0;
+		for (int i = 0; i < frames; i++)
+		{
+			phases[i] = accumulator + (constantPhase ? phaseOffset : toPhase(phaseBlock[i] * 0.5));
+			const uint32_t increment = constantFrequency ? frequencyIncrement : toPhase(frequencyBlock[i] * cyclesPerHertz);
+			accumulator += increment;
+			increments[i] = static_cast<uint32_t>(std::abs(static_cast<int64_t>(static_cast<int32_t>(increment))));
+			maxIncrement = std::max(maxIncrement, increments[i]);
+			lastIncrement = increment;
+		}
+		lastIncrements[context.voice] = lastIncrement;
+
+		switch (type)
+		{
+			case WavetableSquare: Wavetable::get(Wavetable::Square).render(out, phases.data(), maxIncrement, frames); return;
+			case WavetableTriangle: Wavetable::get(Wavetable::Triangle).render(out, phases.data(), maxIncrement, frames); return;
+			case WavetableSaw: Wavetable::get(Wavetable::Saw).render(out, phases.data(), maxIncrement, frames); return;
+			case PolyBlepSquare: case PolyBlepTriangle: case PolyBlepSaw:
+				renderPolyBlep(out, phases.data(), increments.data(), frames);
+				return;
+			default: break;
+		}
+
+		if (type == Saw_Dig)
+		{
+			for (int i = 0; i < frames; i++)
+				out[i] = static_cast<float>(phases[i] * (2.0 / PHASE_RANGE) - 1.0);
+			return;
+		}
+
+		// Read as signed, a phase is an angle in [-pi, pi)
+		AudioBlock angles;
+		for (int i = 0; i < frames; i++)
+			angles[i] = static_cast<float>(static_cast<int32_t>(phases[i]) * (M_PI / 2147483648.0));
 
-		double frequencyValue = getInputsValue(frequency, audioInfos, keyPressed, currentKey);
-		double phaseValue = getInputsValue(phase, audioInfos, keyPressed, currentKey);
+		switch (type)
+		{
+			case Sine: Simd::sine(out, angles.data(), frames); break;
+			case Square: Simd::square(out, angles.data(), frames); break;
+			default: Simd::triangle(out, angles.data(), frames); break;
+		}
+	}
 
-		double value = osc(frequencyValue, M_PI * phaseValue, time, type);
+	/*
+	 * Naive waveforms whose discontinuities are smoothed over the two frames around them by polynomial residuals:
+	 * PolyBLEP for the steps of the square and saw, its integral (PolyBLAMP) for the corners of the triangle.
+	 * Aliasing is much lower than the naive waveforms for a few operations per frame, without any table.
+	*/
+	void renderPolyBlep(float* out, const uint32_t* phases, const uint32_t* increments, int frames) const
+	{
+		constexpr float SCALE = 1.0f / PHASE_RANGE;
+		constexpr uint32_t QUARTER = 1u << 30;
 
-		return value;
+		switch (type)
+		{
+			case PolyBlepSquare:
+				for (int i = 0; i < frames; i++)
+				{
+					const float t = phases[i] * SCALE;
+					const float dt = increments[i] * SCALE;
+					out[i] = (t < 0.5f ? 1.0f : -1.0f) + polyBlep(t, dt) - polyBlep((phases[i] + 2 * QUARTER) * SCALE, dt);
+				}
+				break;
+			case PolyBlepTriangle:
+				// Slope goes from 4 to -4 per cycle at the first corner and back at the second one
+				for (int i = 0; i < frames; i++)
+				{
+					const float t = phases[i] * SCALE;
+					const float dt = increments[i] * SCALE;
+					const float naive = t < 0.25f ? 4.0f * t : (t < 0.75f ? 2.0f - 4.0f * t : 4.0f * t - 4.0f);
+					out[i] = naive + 8.0f * dt * (polyBlamp((phases[i] + QUARTER) * SCALE, dt) - polyBlamp((phases[i] - QUARTER) * SCALE, dt));
+				}
+				break;
+			default:
+				for (int i = 0; i < frames; i++)
+				{
+					const float t = phases[i] * SCALE;
+					out[i] = 2.0f * t - 1.0f - polyBlep(t, increments[i] * SCALE);
+				}
+				break;
+		}
 	}
 
-	double freqToAngularVelocity(double hertz)
+	// Difference between a band-limited and a naive step from -1 to 1 at phase 0, t in [0, 1) cycles and dt the phase increment
+	static float polyBlep(float t, float dt)
 	{
-		return hertz * 2.0 * M_PI;
+		if (t < dt)
+		{
+			t /= dt;
+			return t + t - t * t - 1.0f;
+		}
+		if (t > 1.0f - dt)
+		{
+			t = (t - 1.0f) / dt;
+			return t * t + t + t + 1.0f;
+		}
+		return 0.0f;
 	}
 
-	double whiteNoise()
+	// Difference between a band-limited and a naive corner at phase 0, whose slope increases by one per frame
+	static float polyBlamp(float t, float dt)
 	{
-		return 2.0 * (static_cast<double>(std::rand()) / RAND_MAX) - 1.0;
+		if (t < dt)
+			t = 1.0f - t / dt;
+		else if (t > 1.0f - dt)
+			t = 1.0f + (t - 1.0f) / dt;
+		else
+			return 0.0f;
+		return t * t * t * (1.0f / 6.0f);
 	}
 
-	double osc(double hertz, double phase, double time, OscType type)
+	// Cycles in accumulator units, whole cycles and negative phases wrap around (|cycles| < 2^31)
+	static uint32_t toPhase(double cycles)
 	{
-		double t = freqToAngularVelocity(hertz) * time + phase;
+		return static_cast<uint32_t>(static_cast<int64_t>(cycles * PHASE_RANGE + 0.5));
+	}
 
-		switch(type)
+	void renderNoise(float* out, int voice, int frames)
+	{
+		if (type == WhiteNoise)
 		{
-			case Sine: return sin(t);
-			case Square: return sin(t) > 0 ? 1.0 : -1.0;
-			case Triangle: return asin(sin(t)) * (2.0 / M_PI);
-			case Saw_Dig: return (2.0 / M_PI) * (hertz * M_PI * fmod(time, 1.0 / hertz) - (M_PI / 2.0));
-			case WhiteNoise: return whiteNoise();
-			case PinkNoise: {
-				double white = whiteNoise();
-				// Paul Kellet’s refined pink noise filter
-				pink_b0 = 0.99765 * pink_b0 + white * 0.0990460;
-				pink_b1 = 0.96300 * pink_b1 + white * 0.2965164;
-				pink_b2 = 0.57000 * pink_b2 + white * 1.0526913;
-				// Sound is by default really loud, divide result to prevent it from breaking my ears
-				return (pink_b0 + pink_b1 + pink_b2 + white * 0.1848) / 20.0;
-			}
-			case BrownianNoise: {
-				double white = whiteNoise();
-				// Integrate (bounded to prevent drift)
-				brownLast += white * 0.02;
-				brownLast = std::clamp(brownLast, -1.0, 1.0);
-				return brownLast;
-			}
-
-			default: return 0;
+			Simd::whiteNoise(out, noiseGenerators[voice].data(), frames);
+			return;
 		}
+
+		AudioBlock white;
+		Simd::whiteNoise(white.data(), noiseGenerators[voice].data(), frames);
+		if (type == PinkNoise)
+			Simd::pinkNoise(out, white.data(), pinkStates[voice].data(), frames);
+		else
+			Simd::brownNoise(out, white.data(), &brownStates[voice], frames);
 	}
 };
@@ -8,11 +8,35 @@ struct Overdrive : public AudioComponent {
 
 	Overdrive() : AudioComponent() { inputs.resize(2); componentName = "Overdrive"; }
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	InputRate getInputRate(unsigned int index) const override { return index == drive ? ControlExponential : AudioRate; }
+	bool supportsControlRate() const override { return true; }
+	bool dependsOnlyOnNote() const override { return true; }
+
+	bool getConstantOutput(const std::vector<std::optional<float>>& inputValues, float& value) const override
 	{
-		const double inputValue = getInputsValue(input, audioInfos, keyPressed, currentKey);
-		const double driveValue = getInputsValue(drive, audioInfos, keyPressed, currentKey);
+		if (inputValues[input] && *inputValues[input] == 0.0f)
+		{
+			value = 0.0f;
+			return true;
+		}
+
+		if (!inputValues[input] || !inputValues[drive])
+			return false;
+
+		value = std::tanh(*inputValues[input] * *inputValues[drive]);
+		return true;
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		const float* inputBlock = getInputsBlock(input, context, frames);
+
+		if (isControlSettled(drive, &context, 1))
+		{
+			Simd::tanhScale(out, inputBlock, *constantInputs[drive], frames);
+			return;
+		}
 
-		return std::tanh(inputValue * driveValue);
+		Simd::tanhMultiply(out, inputBlock, getControlBlock(drive, context, frames), frames);
 	}
 };
@@ -1,68 +1,98 @@
 #pragma once
 
 #include <tsf.h>
-#include <set>
+#include <bitset>
 #include "path.hpp"
 #include "AudioComponent.hpp"
 #include "audio_backend.hpp"
+#include "SoundFontCache.hpp"
 
 struct SoundFontPlayer : public AudioComponent {
-	std::set<int> notesOn;
-	tsf* tinySoundFont = nullptr;
+	typedef std::bitset<NOTE_COUNT> NoteMask;
+
+	NoteMask notesOn;
+	tsf* tinySoundFont = nullptr; // Instance owned by the player, see setSoundFont
+	unsigned int sampleRate = 0; // Output sample rate of tinySoundFont
 
 	SoundFontPlayer() : AudioComponent()
 	{
 		inputs.resize(0); componentName = "SoundFontPlayer";
 	}
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed, int currentKey = 0) override
+	~SoundFontPlayer()
 	{
-		if (currentKey != 0 || tinySoundFont == nullptr)
-			return 0;
+		SoundFontCache::release(tinySoundFont);
+	}
 
-		addNotes(keyPressed);
-		removeNotes(keyPressed);
+	// Sound fonts are rendered unweaved, which is the layout of stereo blocks
+	int getOutputChannels() const override { return 2; }
 
-		float synthValue = 0;
-		tsf_render_float(tinySoundFont, &synthValue, 1, 0);
+	bool rendersEveryNote() const override { return true; }
 
-		return static_cast<double>(synthValue);
-	}
-
-	void addNotes(std::vector<MidiInfo>& keyPressed)
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
 	{
-		for (const MidiInfo& key : keyPressed)
+		// The sound font plays every note itself, it is only rendered for the first voice
+		if (context.lane != 0 || context.isReleased() || tinySoundFont == nullptr)
+		{
+			std::fill(out, out + 2 * frames, 0.0f);
+			return;
+		}
+
+		if (sampleRate != audioInfos.sampleRate)
 		{
-			if (notesOn.find(key.keyIndex) == notesOn.end())
-			{
-				notesOn.insert(key.keyIndex);
-				tsf_note_on(tinySoundFont, 0, key.keyIndex, (double)key.velocity / 255.0);
-			}
+			sampleRate = audioInfos.sampleRate;
+			tsf_set_output(tinySoundFont, TSF_STEREO_UNWEAVED, sampleRate, 0);
 		}
+
+		updateNotes(context.keyPressed);
+
+		tsf_render_float(tinySoundFont, out, frames, 0);
 	}
 
-	void removeNotes(std::vector<MidiInfo>& keyPressed)
+	// Notes keep playing even when the output is not needed
+	void skipBlock(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
 	{
-		auto it = notesOn.begin();
-		while (it != notesOn.end())
+		StereoBlock discarded;
+		processBlock(audioInfos, context, discarded.data(), frames);
+	}
+
+	// Must be called with the graph lock held. Held notes start again on the new sound font.
+	// soundFont is an instance from SoundFontCache, the player releases it when it is replaced or destroyed.
+	void setSoundFont(tsf* soundFont)
+	{
+		SoundFontCache::release(tinySoundFont);
+		tinySoundFont = soundFont;
+		sampleRate = 0;
+		notesOn.reset();
+	}
+
+	// Notes pressed or released since the last block are sent to the sound font, one bit per MIDI note
+	void updateNotes(const VoicePool& keyPressed)
+	{
+		NoteMask pressed, held;
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			const VoicePool::Voice& voice = keyPressed[slot];
+			if (voice.phase == VoicePool::Free)
+				continue;
+			held.set(voice.info.keyIndex);
+			if (voice.phase == VoicePool::Pressed)
+				pressed.set(voice.info.keyIndex);
+		}
+
+		// Notes stop once their slot is freed
+		const NoteMask started = pressed & ~notesOn;
+		const NoteMask stopped = notesOn & ~held;
+		if (started.none() && stopped.none())
+			return;
+
+		for (int note = 0; note < NOTE_COUNT; note++)
 		{
-			bool noteStillPlayed = false;
-			for (const MidiInfo& key : keyPressed)
-			{
-				if (key.keyIndex == *it)
-				{
-					noteStillPlayed = true;
-					break;
-				}
-			}
-
-			if (!noteStillPlayed)
-			{
-				tsf_note_off(tinySoundFont, 0, *it);
-				it = notesOn.erase(it);
-			}
-			else
-				it++;
+			if (stopped[note])
+				tsf_note_off(tinySoundFont, 0, note);
+			else if (started[note])
+				tsf_note_on(tinySoundFont, 0, note, (double)keyPressed[keyPressed.find(note)].info.velocity / 255.0);
 		}
+		notesOn = (notesOn | started) & ~stopped;
 	}
 };
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include "AudioBackend/Components/AudioComponent.hpp"
+
+/*
+ * Flat, topologically sorted version of a master component tree.
+ *
+ * Components reachable from master are scheduled after all their inputs and own one block per voice
+ * in a contiguous arena. Each component reads its inputs from the blocks of the components plugged to it,
+ * so a component feeding several inputs is only processed once per voice and per block.
+ * Steps are processed one after the other for all the voices at once (see AudioComponent::processVoices).
+ *
+ * Voices only kept alive by an envelope release run a subset of the schedule: the components leading
+ * to an envelope and the ones downstream of it. On inputs mixing an envelope branch with other
+ * components, released voices only read the envelope branch.
+ *
+ * Before scheduling, the graph is simplified: constant subtrees are folded into constant blocks filled
+ * once, constant zero sources are dropped, multiplications by one are bypassed and chained multipliers
+ * are merged. Components are told which inputs are constant so they can read them once per block.
+ * As every UI edit (links or values) recompiles the plan, folded values never get out of date.
+ *
+ * Components only read through control rate inputs (see AudioComponent::getInputRate), directly or through
+ * other such components, are processed at control rate: one frame per CONTROL_RATE_FRAMES, the consumers
+ * smoothing their values in between. Audio rate sources they read are decimated. Typical modulation branches (keyboard, LFO, envelope driving a filter cutoff)
+ * then cost a fraction of their audio rate price.
+ *
+ * Components whose output only depends on the note (see AudioComponent::dependsOnlyOnNote), such as the keyboard
+ * frequency scaled by a constant, are not scheduled: they are evaluated once when a voice starts and their value
+ * is cached in its slot. Their blocks are filled with the cached value of each voice, and consumers are told
+ * which inputs are note constants (see AudioComponent::inputIsNoteConstant).
+ *
+ * Branches only feeding the gated input of a component (the input of an envelope, or the factors of a multiplier
+ * by an envelope) are evaluated lazily: the gate is checked before the branch is processed, and voices for which
+ * it stays closed during the whole block skip the branch (see AudioComponent::isGateClosed and skipBlock).
+ * Branches carrying every note on the first lane (see AudioComponent::rendersEveryNote) are never skipped.
+ *
+ * Stereo components (see AudioComponent::getOutputChannels) own two channels per voice. Multipliers scaling them
+ * and master keep both channels, other consumers read a mono block the plan fills with the average of the two.
+*/
+class ExecutionPlan {
+public:
+	ExecutionPlan() = default;
+	// Components point to the arena of the plan they were compiled with, a copied plan must be compiled again
+	ExecutionPlan(const ExecutionPlan&) {}
+	ExecutionPlan& operator=(const ExecutionPlan&) { clear(); return *this; }
+
+	void compile(AudioComponent* master, unsigned int sampleRate);
+	void clear();
+
+	void startBlock();
+	void resetVoice(int voice);
+	// Processes the schedule for voices (either all pressed or all released) and adds the master inputs of every voice to the stereo block out
+	void run(const AudioInfos& audioInfos, VoiceContext* voices, int voiceCount, float* out, int frames);
+	// Voice slots still made audible by an envelope or an effect tail
+	void getVoiceTails(VoiceMask& tails) const;
+	// Peak of the master inputs of a voice slot during the last block it was processed
+	float getVoiceLevel(int voice) const { return _voiceLevels[voice]; }
+	// The master inputs of a voice slot stayed silent for SILENT_BLOCKS_BEFORE_SLEEP blocks
+	bool isVoiceSilent(int voice) const { return _silentBlocks[voice] >= SILENT_BLOCKS_BEFORE_SLEEP; }
+
+private:
+	struct Step {
+		AudioComponent* component;
+		float* output;
+		bool runOnRelease;
+		bool controlRate;
+		int gateCheck; // Index of the gate of the component checked by this step, which then does not process it. -1 otherwise.
+		std::vector<int> gates; // Gates skipping this step for the voices they are closed for
+		float* downmix; // Average of the channels of a stereo output read by mono consumers, nullptr otherwise
+	};
+
+	// Component evaluated once per voice
+	struct NoteStep {
+		AudioComponent* component;
+		float* output;
+		bool filled; // Read by scheduled components, its block is filled with the value of each voice
+		std::array<float, MAX_VOICES> values;
+	};
+
+	std::vector<Step> _schedule;
+	std::vector<VoiceMask> _closedGates; // Per gate, lanes it is closed for during the current block
+	std::vector<VoiceContext> _openVoices;
+	std::vector<NoteStep> _noteSchedule;
+	VoiceMask _noteValuesReady;
+	unsigned int _frequenciesVersion = 0; // Note values are computed again when the tuning changes
+	std::vector<AudioComponent*> _voiceTails;
+	std::vector<float> _arena;
+	std::vector<BlockSource> _masterSources;
+	std::vector<BlockSource> _masterReleaseSources;
+	std::array<float, MAX_VOICES> _voiceLevels = {};
+	std::array<int, MAX_VOICES> _silentBlocks = {};
+
+	// Intermediate representation used while compiling, nodes are sorted so sources come first
+	struct PlanNode {
+		AudioComponent* component; // nullptr for constants created by the optimizer
+		std::vector<std::vector<size_t>> sources; // Per input, indices of the nodes plugged to it
+		bool gated = false; // Leads to an envelope
+		bool constant = false;
+		float value = 0.0f;
+		long alias = -1; // Node whose output is read instead of this one
+		bool absorbed = false; // Merged into its only consumer
+		bool controlRate = false; // Processed once per control block
+		bool noteInvariant = false; // Evaluated once per voice
+		int channels = 1;
+		bool downmixed = false; // Stereo output also read by mono consumers
+		int gate = -1; // Index of its gate when the component ignores gatedSources while the gate is closed
+		std::vector<size_t> gatedSources;
+		std::vector<int> gates; // Gates skipping this node when closed
+		bool factorized = false; // Multiplier computed as gain * factors
+		float gain = 1.0f;
+		std::vector<size_t> factors;
+	};
+
+	size_t _componentCount = 0;
+	size_t _scheduledCount = 0;
+	size_t _controlRateCount = 0;
+	size_t _noteInvariantCount = 0;
+
+	enum VisitState { Visiting, Visited };
+	void sortComponents(AudioComponent* component, std::unordered_map<AudioComponent*, VisitState>& visitState, std::vector<AudioComponent*>& order);
+
+	void optimize(std::vector<PlanNode>& nodes);
+	void simplifySources(std::vector<PlanNode>& nodes, std::vector<size_t>& sources);
+	void factorizeMultiplier(std::vector<PlanNode>& nodes, PlanNode& node);
+	void mergeMultipliers(std::vector<PlanNode>& nodes);
+	void findNoteInvariantNodes(std::vector<PlanNode>& nodes, size_t masterIndex);
+	void findControlRateNodes(std::vector<PlanNode>& nodes, size_t masterIndex);
+	void findGates(std::vector<PlanNode>& nodes, size_t masterIndex);
+	void findStereoNodes(std::vector<PlanNode>& nodes, size_t masterIndex);
+	void sortSchedule(const std::vector<PlanNode>& nodes, size_t index, std::vector<bool>& visited, std::vector<std::pair<size_t, bool>>& order) const;
+	std::vector<size_t> getReads(const PlanNode& node) const;
+	void computeNoteValues(const AudioInfos& audioInfos, VoiceContext& context);
+	size_t resolve(const std::vector<PlanNode>& nodes, size_t index) const;
+	std::vector<size_t> getReleaseSources(const std::vector<PlanNode>& nodes, const std::vector<size_t>& sources) const;
+};
@@ -8,5 +8,6 @@ public:
 	std::string name;
 	float volume = 1.0f;
 
-	double process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed);
+	// Renders frames (<= MAX_BLOCK_FRAMES) stereo frames starting at time in out (see StereoBlock)
+	void processBlock(const AudioInfos& audioInfos, const VoicePool& keyPressed, double time, float* out, int frames);
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Vectorized kernels used by the components, selected once at startup from the CPU features.
+ *
+ * x86 builds always have SSE2 (4 floats per instruction) and use AVX2 (8 floats) when the
+ * CPU supports it. Other architectures use the scalar kernels, left to the compiler auto-vectorizer.
+ *
+ * Stateless kernels work on the frames of one block. Recursive ones (filters) cannot be vectorized
+ * over frames, they process one voice per lane instead, each voice reading its own block.
+*/
+namespace Simd {
+
+enum Level { Scalar, SSE2, AVX2 };
+
+Level getLevel();
+const char* getLevelName(Level level);
+
+/*
+ * Accuracy of the approximated functions (tanh, sin, exp2), shared by every component.
+ * Fast uses lower order approximations, Exact uses libm and is not vectorized.
+ * Error bounds of each precision are listed in Simd.cpp, the SimdBenchmark executable measures them.
+*/
+enum Precision { Fast, Accurate, Exact };
+
+// Can be called from any thread, the render thread uses the new precision from its next kernel call
+void setPrecision(Precision precision);
+Precision getPrecision();
+const char* getPrecisionName(Precision precision);
+
+// Flushes denormal numbers to zero for the floating point math of the calling thread
+void disableDenormals();
+
+// out[i] = a[i] * b[i]
+void multiply(float* out, const float* a, const float* b, int frames);
+// out[i] = gain * a[i]
+void scale(float* out, const float* a, float gain, int frames);
+// out[i] += a[i]
+void add(float* out, const float* a, int frames);
+// max(|a[i]|)
+float peak(const float* a, int frames);
+
+// out[i] = tanh(a[i] * b[i])
+void tanhMultiply(float* out, const float* a, const float* b, int frames);
+// out[i] = tanh(a[i] * gain)
+void tanhScale(float* out, const float* a, float gain, int frames);
+
+// out[i] = 2^a[i]
+void exp2(float* out, const float* a, int frames);
+inline float exp2(float a)
+{
+	float result;
+	exp2(&result, &a, 1);
+	return result;
+}
+
+// Waveforms of phases already wrapped in [-pi, pi]
+void sine(float* out, const float* phases, int frames);
+void square(float* out, const float* phases, int frames);
+void triangle(float* out, const float* phases, int frames);
+
+// Noise kernels render bit-identical noise on every level, it only depends on the states.
+// Independent white noise generators of one voice, xorshift32 states that must not be 0
+constexpr int NOISE_LANES = 8;
+// Floats holding the state of the pink noise filter
+constexpr int PINK_STATE_SIZE = 4;
+
+// out[i] = uniform white noise in [-1, 1], frame i is drawn from states[i % NOISE_LANES]
+void whiteNoise(float* out, uint32_t* states, int frames);
+// Paul Kellet's pink noise filter applied to white
+void pinkNoise(float* out, const float* white, float* state, int frames);
+// Integration of white bounded to [-1, 1], state holds the last output
+void brownNoise(float* out, const float* white, float* state, int frames);
+
+// State variable filter with constant parameters, applied to voiceCount voices at once.
+// low and band hold the state of each voice, outputs[v] receives the low or high pass output of inputs[v].
+void stateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames);
+
+}
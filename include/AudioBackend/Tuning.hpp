@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "path.hpp"
+#include "config.hpp"
+
+/*
+ * Frequency of every MIDI note, read by the KeyboardFrequency component with a single lookup.
+ *
+ * The default is 12-TET with A4 (note 69) at 440 Hz, generated at compile time.
+ * Scala files replace it: a .scl scale gives the pitch of each degree, a .kbm keyboard mapping tells which
+ * degree each note plays and which note is tuned to the reference frequency. Both are resolved into the
+ * same table when they are loaded, so alternate tunings cost nothing while playing.
+ *
+ * Scale file format: https://www.huygens-fokker.org/scala/scl_format.html
+*/
+class Tuning {
+public:
+	using Table = std::array<float, NOTE_COUNT>;
+
+	static const Table EQUAL_TEMPERAMENT;
+
+	Tuning();
+
+	// Return true on error, the tuning is then left unchanged
+	bool loadScale(const fs::path& filepath);
+	bool loadKeyboardMapping(const fs::path& filepath);
+
+	// Back to 12-TET and the default keyboard mapping
+	void reset();
+
+	const Table& getFrequencies() const { return _frequencies; }
+	const std::string& getScaleName() const { return _scaleName; }
+	const std::string& getMappingName() const { return _mappingName; }
+
+private:
+	struct KeyboardMapping {
+		int firstNote = 0;
+		int lastNote = NOTE_COUNT - 1;
+		int middleNote = 60; // Plays the first degree of the scale (1/1)
+		int referenceNote = 69;
+		double referenceFrequency = 440.0;
+		int octaveDegree = 0; // Degree repeating the pattern, 0 uses the last degree of the scale
+		std::vector<int> degrees; // Degree played by each key of the pattern, -1 if unmapped. Empty maps keys to consecutive degrees.
+	};
+
+	std::vector<double> _ratios; // Ratio to 1/1 of each degree, the last one is the period of the scale
+	KeyboardMapping _mapping;
+	Table _frequencies;
+	std::string _scaleName;
+	std::string _mappingName;
+
+	static bool readLines(const fs::path& filepath, std::vector<std::string>& lines);
+	static bool parseInteger(const std::string& line, int& value);
+	static bool parsePitch(const std::string& line, double& ratio);
+
+	// Ratio to 1/1 of any degree, degrees past the last one are transposed by the period
+	static double getDegreeRatio(const std::vector<double>& ratios, int degree);
+	// Frequencies of unmapped notes are 0. Returns true when the reference note is unmapped.
+	static bool buildTable(const std::vector<double>& ratios, const KeyboardMapping& mapping, Table& table);
+};
+
+// 12-TET frequencies with A4 at 440 Hz. Octaves are exact powers of two, each note needs at most eleven semitone multiplications.
+constexpr Tuning::Table buildEqualTemperament()
+{
+	constexpr double SEMITONE = 1.0594630943592952646; // 2^(1/12)
+
+	Tuning::Table table = {};
+	for (int note = 0; note < NOTE_COUNT; note++)
+	{
+		const int semitones = note - 69 + 120; // Counted from ten octaves under A4 so the division rounds down
+		double frequency = 440.0 / 1024.0;
+		for (int octave = 0; octave < semitones / 12; octave++)
+			frequency *= 2.0;
+		for (int semitone = 0; semitone < semitones % 12; semitone++)
+			frequency *= SEMITONE;
+		table[note] = static_cast<float>(frequency);
+	}
+	return table;
+}
+
+inline constexpr Tuning::Table Tuning::EQUAL_TEMPERAMENT = buildEqualTemperament();
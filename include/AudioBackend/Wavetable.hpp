@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Band-limited single cycle waveforms played by table lookup.
+ *
+ * Each shape is stored once per octave (mip level), level m only keeping the first 1024 >> m harmonics.
+ * The level is chosen from the phase increment so that no harmonic goes past the Nyquist frequency,
+ * which only depends on the ratio between frequency and sample rate: tables are built once at startup
+ * and stay valid when the sample rate changes.
+ *
+ * Phases use the oscillator accumulator units, one cycle spanning the whole uint32_t range.
+*/
+class Wavetable {
+public:
+	enum Shape { Square, Triangle, Saw, ShapeCount };
+
+	static const Wavetable& get(Shape shape);
+
+	// Linearly interpolated lookup of phases, increment is the largest absolute phase advance per frame in the block
+	void render(float* out, const uint32_t* phases, uint32_t increment, int frames) const;
+
+private:
+	static constexpr int SIZE_BITS = 12;
+	static constexpr int SIZE = 1 << SIZE_BITS;
+	static constexpr int LEVEL_COUNT = 11;
+	static constexpr int MAX_HARMONICS = 1 << (LEVEL_COUNT - 1); // Four samples per period of the highest harmonic
+
+	// One extra sample per level, equal to the first one, so the interpolation never wraps
+	std::array<std::vector<float>, LEVEL_COUNT> _levels;
+
+	static const std::array<Wavetable, ShapeCount> _tables;
+
+	explicit Wavetable(Shape shape);
+	static double getHarmonicAmplitude(Shape shape, int harmonic);
+	static std::array<Wavetable, ShapeCount> buildTables();
+};
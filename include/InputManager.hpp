@@ -123,7 +123,7 @@ public:
 	~InputManager();
 
 	void updateModifierKey(unsigned int key, bool pressed);
-	void updateKeysState(const MidiPlayerSettings& settings, std::vector<MidiInfo>& keyPressed);
+	void updateKeysState(const MidiPlayerSettings& settings, VoicePool& keyPressed);
 	void createKeysEvents(std::queue<Message>& messageQueue);
 
 	void pollMidiDevices(bool log = false);
@@ -136,8 +136,8 @@ public:
 private:
 	static void glfwKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
-	void addKeyPressed(std::vector<MidiInfo>& keyPressed, int keyIndex, int velocity) const;
-	void removeKeyPressed(std::vector<MidiInfo>& keyPressed, int keyIndex) const;
+	void addKeyPressed(VoicePool& keyPressed, int keyIndex, int velocity) const;
+	void removeKeyPressed(VoicePool& keyPressed, int keyIndex) const;
 
 	bool openMidiDevice(const MidiDevice& device, bool log = false);
 };
@@ -28,7 +28,7 @@ private:
 	MidiPlayerSettings _settings;
 	ApplicationPath _applicationPath;
 
-	std::vector<MidiInfo> _keyPressed = {};
+	VoicePool _keyPressed = {};
 	std::vector<Instrument> _instruments = {};
 	std::queue<Message> _messageQueue = {};
 
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+/*
+ * Lock-free single producer / single consumer ring buffer.
+ *
+ * One thread writes, one other thread reads. Each cursor is only moved by its owner and
+ * published with release semantics, the other side loads it with acquire semantics so
+ * the data copied before moving a cursor is visible once the new cursor value is seen.
+ *
+ * Cursors are free running counters, the slot index is obtained by masking them,
+ * which is why the capacity is always rounded up to a power of two.
+*/
+template<typename T>
+class RingBuffer {
+	static_assert(std::is_trivially_copyable<T>::value, "RingBuffer elements are copied with memcpy");
+
+public:
+	RingBuffer(size_t capacity = 0)
+		: _capacity(0), _mask(0), _readCursor(0), _writeCursor(0)
+	{
+		resize(capacity);
+	}
+
+	// Not thread safe: producer and consumer must both be stopped.
+	void resize(size_t capacity)
+	{
+		_capacity = roundUpToPowerOfTwo(capacity);
+		_mask = _capacity - 1;
+		_data = std::make_unique<T[]>(_capacity);
+		clear();
+	}
+
+	// Not thread safe: producer and consumer must both be stopped.
+	void clear()
+	{
+		std::memset((void*)_data.get(), 0, sizeof(T) * _capacity);
+		_readCursor.store(0, std::memory_order_relaxed);
+		_writeCursor.store(0, std::memory_order_relaxed);
+	}
+
+	// ----------------- PRODUCER -----------------
+
+	// Copy up to count elements, returns the number of elements actually written
+	size_t write(const T* data, size_t count)
+	{
+		const size_t writeCursor = _writeCursor.load(std::memory_order_relaxed);
+		const size_t readCursor = _readCursor.load(std::memory_order_acquire);
+
+		count = std::min(count, _capacity - (writeCursor - readCursor));
+		copyWrapped(_data.get(), writeCursor & _mask, data, count);
+
+		_writeCursor.store(writeCursor + count, std::memory_order_release);
+		return count;
+	}
+
+	size_t writeAvailable() const
+	{
+		return _capacity - (_writeCursor.load(std::memory_order_relaxed) - _readCursor.load(std::memory_order_acquire));
+	}
+
+	// ----------------- CONSUMER -----------------
+
+	// Copy up to count elements, returns the number of elements actually read
+	size_t read(T* data, size_t count)
+	{
+		const size_t readCursor = _readCursor.load(std::memory_order_relaxed);
+		const size_t writeCursor = _writeCursor.load(std::memory_order_acquire);
+
+		count = std::min(count, writeCursor - readCursor);
+
+		const size_t start = readCursor & _mask;
+		const size_t firstPart = std::min(count, _capacity - start);
+		std::memcpy(data, _data.get() + start, sizeof(T) * firstPart);
+		std::memcpy(data + firstPart, _data.get(), sizeof(T) * (count - firstPart));
+
+		_readCursor.store(readCursor + count, std::memory_order_release);
+		return count;
+	}
+
+	// Same as read without copying the data
+	size_t skip(size_t count)
+	{
+		const size_t readCursor = _readCursor.load(std::memory_order_relaxed);
+		const size_t writeCursor = _writeCursor.load(std::memory_order_acquire);
+
+		count = std::min(count, writeCursor - readCursor);
+		_readCursor.store(readCursor + count, std::memory_order_release);
+		return count;
+	}
+
+	size_t readAvailable() const
+	{
+		return _writeCursor.load(std::memory_order_acquire) - _readCursor.load(std::memory_order_relaxed);
+	}
+
+	// ----------------- OBSERVERS -----------------
+	// Can be called from any thread, values might be outdated as soon as they are returned.
+
+	size_t getCapacity() const { return _capacity; }
+	size_t getReadIndex() const { return _readCursor.load(std::memory_order_relaxed) & _mask; }
+	size_t getWriteIndex() const { return _writeCursor.load(std::memory_order_relaxed) & _mask; }
+
+private:
+	std::unique_ptr<T[]> _data;
+	size_t _capacity;
+	size_t _mask;
+
+	// Keep cursors on their own cache line so producer and consumer do not invalidate each other
+	alignas(64) std::atomic<size_t> _readCursor;
+	alignas(64) std::atomic<size_t> _writeCursor;
+
+	void copyWrapped(T* destination, size_t start, const T* source, size_t count)
+	{
+		const size_t firstPart = std::min(count, _capacity - start);
+		std::memcpy(destination + start, source, sizeof(T) * firstPart);
+		std::memcpy(destination, source + firstPart, sizeof(T) * (count - firstPart));
+	}
+
+	static size_t roundUpToPowerOfTwo(size_t value)
+	{
+		size_t powerOfTwo = 1;
+		while (powerOfTwo < value)
+			powerOfTwo <<= 1;
+		return powerOfTwo;
+	}
+};
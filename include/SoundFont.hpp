@@ -1,18 +1,68 @@
 #pragma once
 
 #include <tsf.h>
+#include <atomic>
+#include <fstream>
+#include <thread>
 #include "path.hpp"
 #include "Logger.hpp"
 
+/*
+ * Sound font of a SoundFontPlayerNode.
+ *
+ * Large files take seconds to parse, they are loaded by a background thread while the previous
+ * sound font keeps playing. The UI thread polls finishLoading, which hands the new sound font over.
+ * Files already loaded by another player are shared (see SoundFontCache).
+ *
+ * The player is given its own instance (SoundFontCache::share) and releases it itself,
+ * so destroying or replacing this sound font never frees what the render thread plays.
+*/
 class SoundFont {
 public:
+	SoundFont() = default;
+	SoundFont(const SoundFont&) = delete;
+	SoundFont& operator=(const SoundFont&) = delete;
 	~SoundFont();
 
-	bool loadSoundFontFile(const fs::path& filepath, const unsigned int& sampleRate);
+	// Starts loading the file in the background, a load already running is cancelled
+	void loadSoundFontFile(const fs::path& filepath);
+
+	// Returns true when a load finished since the last call, the player must then be given an instance of getSoundFont().
+	// The previous sound font is kept when the file could not be loaded.
+	bool finishLoading();
+
+	bool isLoading() const { return _loader.joinable(); }
+	bool isLoadFinished() const { return _loadFinished; }
+	float getLoadingProgress() const { return _progress; }
+
 	tsf* getSoundFont();
+	const fs::path& getFilepath() const { return _filepath; }
 
 private:
 	tsf* _tinySoundFont = nullptr;
+	fs::path _filepath; // File of _tinySoundFont
+
+	// ----------------- BACKGROUND LOADING -----------------
+	std::thread _loader;
+	fs::path _loadingFilepath;
+	std::atomic<bool> _loadFinished = false;
+	std::atomic<bool> _cancelLoading = false;
+	std::atomic<float> _progress = 0.0f; // Part of the file read, between 0 and 1
+	tsf* _loadedSoundFont = nullptr; // Written by the loader before _loadFinished is set
+	bool _openFailed = false;
+
+	// tsf_stream reading the file being loaded
+	struct LoadingStream {
+		SoundFont* soundFont;
+		std::ifstream file;
+		size_t size;
+		size_t position;
+
+		static int read(void* data, void* ptr, unsigned int size);
+		static int skip(void* data, unsigned int count);
+	};
 
+	void load();
+	void cancelLoading();
 	void deleteLoadedSoundFont();
 };
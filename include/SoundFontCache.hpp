@@ -0,0 +1,62 @@
+#pragma once
+
+#include <tsf.h>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include "path.hpp"
+
+/*
+ * Sound fonts parsed by the application, shared by every SoundFontPlayer loading the same file.
+ *
+ * Each player gets its own instance made with tsf_copy: voices and output settings (sample rate) belong to the
+ * instance while presets and samples are shared, so a duplicated bank only costs its voices.
+ * A file is parsed once and freed when its last instance is released.
+ * Entries are keyed by the modification time and size of the file as well, a file changed on disk is parsed again
+ * while the instances of its previous content keep playing it.
+ *
+ * TinySoundFont counts the instances of a sound font without synchronization,
+ * they must all be created and closed here.
+*/
+class SoundFontCache {
+public:
+	struct Key {
+		fs::path path; // Canonical path of the file
+		fs::file_time_type lastWriteTime;
+		uintmax_t size;
+
+		bool operator<(const Key& other) const
+		{
+			return std::tie(path, lastWriteTime, size) < std::tie(other.path, other.lastWriteTime, other.size);
+		}
+	};
+
+	// Taken before the file is parsed, a file modified meanwhile is parsed again by the next load
+	static Key getKey(const fs::path& filepath);
+
+	// New instance of a file already parsed, nullptr if it is not cached
+	static tsf* acquire(const Key& key);
+
+	// Caches soundFont, parsed from the file of key, and returns a new instance of it.
+	// If the file was cached by another thread meanwhile, soundFont is closed and the cached one is used.
+	static tsf* insert(const Key& key, tsf* soundFont);
+
+	// New instance of the file of an instance, nullptr if instance is nullptr
+	static tsf* share(tsf* instance);
+
+	// Closes an instance returned by acquire, insert or share
+	static void release(tsf* instance);
+
+private:
+	struct Entry {
+		tsf* soundFont; // Never played, instances are copied from it
+		int instanceCount;
+	};
+
+	static std::mutex _mutex;
+	static std::map<Key, Entry> _entries;
+	static std::unordered_map<tsf*, Key> _instances; // File of each instance
+
+	static tsf* copy(const Key& key, Entry& entry);
+};
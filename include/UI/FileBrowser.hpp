@@ -11,6 +11,7 @@ private:
 	ImGui::FileBrowser _browser;
 	bool _isOpen = false;
 	unsigned int _callerNodeId;
+	MessageId _responseId;
 
 public:
 	void update(std::queue<Message>& messages);
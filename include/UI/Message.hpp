@@ -21,6 +21,7 @@ typedef unsigned int MessageId;
 #define SEND_NODE_FILEPATH 0x0b
 #define AUDIO_SAMPLE_RATE_UPDATED 0x0c
 #define AUDIO_CHANNELS_UPDATED 0x0d
+#define SEND_TUNING_FILEPATH 0x0e
 
 struct Message {
 	MessageId id;
@@ -39,6 +40,7 @@ struct FileBrowserOpenData {
 	std::string title;
 	std::vector<std::string> filter;
 	unsigned int nodeId; // node who made the call to get some file
+	MessageId responseId = SEND_NODE_FILEPATH; // message sent with the selected file
 };
 
 struct NodeFilepathData {
@@ -14,6 +14,7 @@
 #include "fa-solid-900.h"
 
 #include "AudioBackend/Instrument.hpp"
+#include "AudioBackend/Tuning.hpp"
 
 #include <map>
 
@@ -55,6 +56,8 @@ private:
 
 	Instrument* _selectedInstrument;
 
+	Tuning _tuning;
+
 public:
 	UI(GLFWwindow* window, Audio& audio, const ApplicationPath& path);
 	void update(Window& window, Audio& audio, std::vector<Instrument>& instruments, MidiPlayerSettings& settings, std::queue<Message>& messageQueue, InputManager& inputManager);
@@ -90,6 +93,10 @@ private:
 	void updateAudioChannels(Audio& audio, std::queue<Message>& messageQueue);
 	void updateAudioLatency(Audio& audio);
 	void updateMuteAudio(Audio& audio);
+	void updateMathPrecision();
+	void updateVoiceSettings(Instrument& instrument);
 	void updateMidiSettings(InputManager& inputManager, MidiPlayerSettings& settings);
+	void updateTuning(std::queue<Message>& messageQueue);
+	void loadTuningFile(const fs::path& filepath);
 	void updateUISettings(MidiPlayerSettings& settings);
 };
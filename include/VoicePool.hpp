@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include "config.hpp"
+
+struct MidiInfo
+{
+	int keyIndex;
+	int velocity; // between 0 and 255
+	bool risingEdge; // Only true for the first frame, becomes false when holding key
+};
+
+/*
+ * Fixed capacity set of voices indexed by slot, it never allocates.
+ *
+ * The UI fills one with the pressed keys and publishes copies of it to the render thread.
+ * Each instrument master keeps its own to bind notes to the slots holding their component state,
+ * released notes stay in their slot while an envelope or an effect tail keeps them audible.
+ *
+ * Note 0 is the voice played when no key is pressed, it always uses slot 0.
+*/
+class VoicePool {
+public:
+	enum Phase { Free, Pressed, Released };
+
+	struct Voice {
+		MidiInfo info = {};
+		Phase phase = Free;
+		unsigned long age = 0; // Order in which notes were pressed, smaller is older
+	};
+
+	// Slot already used by note, -1 if none
+	int find(int note) const
+	{
+		for (int slot = 0; slot < MAX_VOICES; slot++)
+		{
+			if (_voices[slot].phase != Free && _voices[slot].info.keyIndex == note)
+				return slot;
+		}
+		return -1;
+	}
+
+	// Marks the note as pressed, in its current slot or in a free one. Returns -1 when every slot is used.
+	int press(const MidiInfo& info)
+	{
+		int slot = find(info.keyIndex);
+		if (slot == -1)
+			slot = findFreeSlot(info.keyIndex);
+		if (slot == -1)
+			return -1;
+
+		Voice& voice = _voices[slot];
+		if (voice.phase != Pressed)
+			voice.age = _pressCount++;
+		voice.info = info;
+		voice.phase = Pressed;
+		return slot;
+	}
+
+	void release(int slot)
+	{
+		_voices[slot].phase = Released;
+		_voices[slot].info.risingEdge = false;
+	}
+
+	void free(int slot) { _voices[slot].phase = Free; }
+
+	void clearRisingEdges()
+	{
+		for (Voice& voice : _voices)
+			voice.info.risingEdge = false;
+	}
+
+	bool hasPressedVoices() const
+	{
+		for (const Voice& voice : _voices)
+		{
+			if (voice.phase == Pressed)
+				return true;
+		}
+		return false;
+	}
+
+	const Voice& operator[](int slot) const { return _voices[slot]; }
+
+private:
+	std::array<Voice, MAX_VOICES> _voices = {};
+	unsigned long _pressCount = 0;
+
+	int findFreeSlot(int note) const
+	{
+		if (note == 0)
+			return _voices[0].phase == Free ? 0 : -1;
+
+		for (int slot = 1; slot < MAX_VOICES; slot++)
+		{
+			if (_voices[slot].phase == Free)
+				return slot;
+		}
+		return -1;
+	}
+};
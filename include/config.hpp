@@ -5,3 +5,30 @@
 #define ID_MANAGER_VERBOSE false
 
 #define DEFAULT_MAX_ID 10000
+
+// Maximum number of frames processed at once by the audio components
+#define MAX_BLOCK_FRAMES 128
+
+// Frames per control block: control rate inputs are read once per control block and smoothed in between.
+// Must divide MAX_BLOCK_FRAMES.
+#define CONTROL_RATE_FRAMES 16
+
+// Maximum number of voices (pressed and released notes) played at once by an instrument.
+// Slot 0 is reserved for the voice played when no key is pressed.
+#define MAX_VOICES 32
+
+// Default number of notes an instrument plays at once, older and quieter voices are stolen past it.
+// Instruments can go up to MAX_VOICES - 1 (slot 0 being reserved).
+#define DEFAULT_VOICE_LIMIT 16
+
+// Longest delay of the comb filters in seconds, their delay lines are allocated for it when the plan is compiled
+#define COMB_FILTER_MAX_DELAY_SECONDS 0.5
+
+// Number of MIDI notes
+#define NOTE_COUNT 128
+
+// Peak below which a block is considered silent (-80 dB)
+#define SILENCE_THRESHOLD 0.0001f
+
+// Number of silent blocks after which released voices are stopped and filters put to sleep
+#define SILENT_BLOCKS_BEFORE_SLEEP 8
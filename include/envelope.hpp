@@ -1,25 +1,46 @@
 #pragma once
 
-#include <iostream>
+#include <algorithm>
 #include <MidiMath.hpp>
 
 enum Phase { Attack, Decay, Sustain, Release, Inactive, Retrigger };
 
-struct sEnvelopeADSR
+/*
+ * Quadratic Bézier curve of an envelope phase.
+ *
+ * The curve parameter advances linearly with time, so the amplitude is a quadratic polynomial of the frame index.
+ * It is evaluated by forward differencing: the amplitude and its differences are computed once when the phase starts,
+ * each frame then only costs two additions.
+*/
+struct EnvelopeSegment
 {
-	unsigned int keyIndex;
-
-	double triggerOffTime;
-	double triggerOnTime;
-	bool noteOn;
-
-	bool retrigger;
-	double amplitudeBeforeRetrigger;
-	double amplitudeAtOffTrigger;
-
-	Phase phase;
-	double amplitude;
+	double a = 0.0, b = 0.0, c = 0.0; // amplitude = (a * t + b) * t + c
+	double t0 = 0.0; // Parameter at frame 0 of the phase
+	double dt = 0.0; // Parameter increment per frame
+
+	EnvelopeSegment() = default;
+	// Curve from p0 to p2 played from startX to endX seconds, frame 0 being at time 0
+	EnvelopeSegment(double p0, double p1, double p2, double startX, double endX, double sampleRate)
+		: a(p0 - 2.0 * p1 + p2), b(2.0 * (p1 - p0)), c(p0)
+	{
+		// A phase without duration stays at its end
+		if (endX > startX)
+		{
+			t0 = -startX / (endX - startX);
+			dt = 1.0 / (sampleRate * (endX - startX));
+		}
+		else
+			t0 = 1.0;
+	}
+};
 
+/*
+ * Segments of an envelope, computed from the control points drawn in the envelope editor and shared by every voice.
+ * Attack and decay are counted from the note on, release from the note off.
+ * Release and retrigger start from the amplitude of the voice, their segments are built by each voice.
+*/
+struct EnvelopeShape
+{
 	Vec2 controlPoints[8] = {
 		{0.0f, 0.0f}, // static 0
 		{1.0f, 0.0f}, // ctrl 0
@@ -31,118 +52,183 @@ struct sEnvelopeADSR
 		{4.0f, 0.0f}  // static 4 | release
 	};
 
-	sEnvelopeADSR()
+	double sampleRate = 0.0;
+	unsigned int version = 0; // Incremented on each change, voices then recompute their differences
+
+	EnvelopeSegment attack;
+	EnvelopeSegment decay;
+	// Last frame of each phase
+	unsigned long attackEnd = 0;
+	unsigned long decayEnd = 0;
+	unsigned long releaseEnd = 0;
+
+	void setControlPoints(const Vec2* points)
 	{
-		noteOn = false;
-		triggerOffTime = 0.0;
-		triggerOnTime = 0.0;
-		retrigger = false;
-		phase = Inactive;
-		amplitude = 0.0;
+		std::copy(points, points + 8, controlPoints);
+		update();
 	}
 
-	double GetAmplitude(double time, bool notePressed)
+	void setSampleRate(double newSampleRate)
 	{
-		if (notePressed && !noteOn)
-		{
-			triggerOnTime = time;
-			noteOn = true;
-			//std::cout << "NOTE ON" << std::endl;
-		}
-		else if (!notePressed && noteOn)
-		{
-			triggerOffTime = time;
-			noteOn = false;
-			//std::cout << "NOTE OFF" << std::endl;
-		}
+		sampleRate = newSampleRate;
+		update();
+	}
 
-		if (triggerOnTime == 0.0f)
-			return 0;
+	EnvelopeSegment getRelease(double start) const
+	{
+		return EnvelopeSegment(start, controlPoints[6].y, controlPoints[7].y, 0.0, controlPoints[7].x - controlPoints[5].x, sampleRate);
+	}
 
-		double lifeTime = time - triggerOnTime;
+	// Straight line from the amplitude of the interrupted release to the attack peak
+	EnvelopeSegment getRetrigger(double start) const
+	{
+		return EnvelopeSegment(start, (start + controlPoints[2].y) * 0.5, controlPoints[2].y, 0.0, controlPoints[2].x, sampleRate);
+	}
 
-		Phase newPhase = getPhase(time);
+	double getSustain() const { return controlPoints[4].y; }
 
-		if (newPhase == Retrigger && phase == Release) // Press key while its release phase is not finished
-			amplitudeBeforeRetrigger = amplitude;
-		else if (newPhase == Release && phase != Release) // Save last amplitude before note off
-			amplitudeAtOffTrigger = amplitude;
+private:
+	void update()
+	{
+		version++;
+		attack = EnvelopeSegment(controlPoints[0].y, controlPoints[1].y, controlPoints[2].y, controlPoints[0].x, controlPoints[2].x, sampleRate);
+		decay = EnvelopeSegment(controlPoints[2].y, controlPoints[3].y, controlPoints[4].y, controlPoints[2].x, controlPoints[4].x, sampleRate);
+		attackEnd = toFrames(controlPoints[2].x);
+		decayEnd = toFrames(controlPoints[4].x);
+		releaseEnd = toFrames(controlPoints[7].x - controlPoints[5].x);
+	}
 
-		phase = newPhase;
+	unsigned long toFrames(double seconds) const
+	{
+		return static_cast<unsigned long>(std::max(seconds, 0.0) * sampleRate);
+	}
+};
 
-		switch (phase)
-		{
-			case Phase::Attack : {
-				Vec2 p = bezierQuadratic(controlPoints[0], controlPoints[1], controlPoints[2], \
-					inverseLerp(controlPoints[0].x, controlPoints[2].x, lifeTime));
-				amplitude = p.y;
-				break;
-			}
-			case Phase::Decay : {
-				retrigger = false;
-				Vec2 p = bezierQuadratic(controlPoints[2], controlPoints[3], controlPoints[4], \
-					inverseLerp(controlPoints[2].x, controlPoints[4].x, lifeTime));
-				amplitude = p.y;
-				break;
-			}
+// Envelope of one voice
+struct sEnvelopeADSR
+{
+	Phase phase = Inactive;
+	bool noteOn = false;
+	unsigned long frame = 0; // Frames since note on, or since note off once released
+
+	double amplitude = 0.0; // Last output
+	double start = 0.0; // Amplitude when the release or the retrigger started
+
+	// Forward differences of the current phase, between two outputs frameStride frames apart
+	double value = 0.0;
+	double step = 0.0;
+	double stepChange = 0.0;
+	unsigned int shapeVersion = 0;
+	int frameStride = 1;
+
+	// Writes the amplitude of the next frames, pressed being the state of the note during all of them.
+	// Each output is frameStride frames after the previous one (envelopes processed at control rate).
+	void render(const EnvelopeShape& shape, bool pressed, float* out, int frames, int stride = 1)
+	{
+		if (pressed != noteOn)
+			trigger(shape, pressed);
 
-			case Phase::Sustain : {
-				amplitude = controlPoints[4].y;
-				break;
-			}
+		// Only the differences depend on the stride, the envelope goes on from the same frame
+		if (stride != frameStride)
+		{
+			frameStride = stride;
+			restartPhase(shape);
+		}
 
-			case Phase::Release : {
-				Vec2 start = {controlPoints[5].x, (float)amplitudeAtOffTrigger};
-				Vec2 p = bezierQuadratic(start, controlPoints[6], controlPoints[7], \
-					inverseLerp(0, controlPoints[7].x - controlPoints[5].x, time - triggerOffTime));
-				amplitude = p.y;
-				break;
+		int i = 0;
+		while (i < frames)
+		{
+			if (shapeVersion != shape.version)
+				restartPhase(shape);
+
+			// Outputs until the end of the phase
+			const unsigned long remaining = (getPhaseEnd(shape) - frame) / frameStride;
+			const int count = remaining < static_cast<unsigned long>(frames - i) ? static_cast<int>(remaining) + 1 : frames - i;
+			for (int j = 0; j < count; j++)
+			{
+				amplitude = value <= 0.0001 ? 0.0 : value; // Silent under -80 dB
+				out[i + j] = static_cast<float>(amplitude);
+				value += step;
+				step += stepChange;
 			}
+			frame += static_cast<unsigned long>(count) * frameStride;
+			i += count;
 
-			case Phase::Inactive :
-				amplitude = 0.0;
-				triggerOnTime = 0;
-				triggerOffTime = 0;
-				amplitudeAtOffTrigger = 0;
-				break;
-
-			case Phase::Retrigger :
-				amplitude = (lifeTime / controlPoints[2].x) * (controlPoints[2].y - amplitudeBeforeRetrigger) + amplitudeBeforeRetrigger;
-				break;
+			while (frame > getPhaseEnd(shape))
+				nextPhase(shape);
 		}
+	}
 
+private:
+	void trigger(const EnvelopeShape& shape, bool pressed)
+	{
+		noteOn = pressed;
+		frame = 0;
+		start = amplitude;
+		if (!pressed)
+			phase = Release;
+		else
+			phase = phase == Release ? Retrigger : Attack; // Key pressed again before the end of its release
+		startPhase(shape);
+	}
 
-		if (amplitude <= 0.0001)
-			amplitude = 0.0;
-
-		//std::cout << time << " " << amplitude << " " << (retrigger ? 6 : phase) << std::endl;
-
-		return amplitude;
+	// Last frame of the phase, sustain and inactive phases never end by themselves
+	unsigned long getPhaseEnd(const EnvelopeShape& shape) const
+	{
+		switch (phase)
+		{
+			case Attack: case Retrigger: return shape.attackEnd;
+			case Decay: return shape.decayEnd;
+			case Release: return shape.releaseEnd;
+			default: return ~0ul;
+		}
 	}
 
-private:
-	Phase getPhase(double time)
+	void nextPhase(const EnvelopeShape& shape)
 	{
-		if (!noteOn)
+		switch (phase)
 		{
-			if (time - triggerOffTime <= controlPoints[7].x - controlPoints[5].x)
-				return Phase::Release;
-			else
-				return Phase::Inactive;
+			case Attack: case Retrigger: phase = Decay; break;
+			case Decay: phase = Sustain; break;
+			default: phase = Inactive; break;
 		}
+		startPhase(shape);
+	}
 
-		const double lifeTime = time - triggerOnTime;
+	// Differences of the current phase at the current frame, with the shape possibly edited since the phase started
+	void restartPhase(const EnvelopeShape& shape)
+	{
+		startPhase(shape);
+		// The edit may have moved the end of the phase before the current frame
+		while (frame > getPhaseEnd(shape))
+			nextPhase(shape);
+	}
 
-		if (triggerOffTime != 0.0 && triggerOnTime != 0.0f \
-				&& triggerOnTime - triggerOffTime < (controlPoints[7].x - controlPoints[5].x) \
-				&& lifeTime <= controlPoints[2].x)
-			return Phase::Retrigger;
+	// Differences of the current phase at the current frame
+	void startPhase(const EnvelopeShape& shape)
+	{
+		shapeVersion = shape.version;
 
-		if (lifeTime <= controlPoints[2].x)
-			return Phase::Attack;
-		else if (lifeTime <= controlPoints[4].x)
-			return Phase::Decay;
-		else
-			return Phase::Sustain;
+		EnvelopeSegment segment;
+		switch (phase)
+		{
+			case Attack: segment = shape.attack; break;
+			case Decay: segment = shape.decay; break;
+			case Retrigger: segment = shape.getRetrigger(start); break;
+			case Release: segment = shape.getRelease(start); break;
+			case Sustain:
+				value = shape.getSustain();
+				step = stepChange = 0.0;
+				return;
+			default:
+				value = step = stepChange = 0.0;
+				return;
+		}
+
+		const double t = segment.t0 + frame * segment.dt;
+		const double dt = segment.dt * frameStride;
+		value = (segment.a * t + segment.b) * t + segment.c;
+		step = segment.a * dt * (2.0 * t + dt) + segment.b * dt;
+		stepChange = 2.0 * segment.a * dt * dt;
 	}
 };
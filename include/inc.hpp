@@ -31,6 +31,7 @@
 #include <imgui_node_editor.h>
 
 #include <Logger.hpp>
+#include "VoicePool.hpp"
 
 // [TODO] This should not be in UI
 #include <UI/Message.hpp>
@@ -55,11 +56,20 @@ struct AudioInfos {
 	unsigned int channels = {};
 };
 
-struct MidiInfo
-{
-	int keyIndex;
-	int velocity; // between 0 and 255
-	bool risingEdge; // Only true for the first frame, becomes false when holding key
+// Describes which voice a block is processed for and when it starts
+struct VoiceContext {
+	const VoicePool& keyPressed; // Every key pressed during the block
+	const MidiInfo* key; // Key played by this voice, nullptr when there is none
+	int voice; // Slot holding the voice state in the components
+	int lane; // Index of the voice among the ones processed together, selects its blocks in the plan
+	bool released; // The key was released, the voice is only kept alive by an envelope or an effect tail
+	double time; // Time of the first frame of the block
+	double deltaTime; // Duration of one frame
+	bool fading = false; // Last block of a stolen voice, its output is faded out
+	int frameStride = 1; // Audio frames per processed frame, CONTROL_RATE_FRAMES for components processed at control rate
+
+	bool isReleased() const { return released; }
+	double getTime(int frame) const { return time + frame * deltaTime; }
 };
 
 struct Timer {
@@ -8,6 +8,7 @@
 #include "UI/Message.hpp"
 #include "MidiMath.hpp"
 #include "SoundFont.hpp"
+#include "SoundFontCache.hpp"
 
 #include "AudioBackend/Components/Components.hpp"
 
@@ -328,8 +329,9 @@ struct OscNode : public Node
 {
 	OscType oscType;
 	bool doPopup = false;
-	static constexpr int oscTypeNumber = 7;
-	std::string popupText[oscTypeNumber] = {"Sine", "Square", "Triangle", "Saw_Dig", "White noise", "Pink noise", "Brownian noise"};
+	static constexpr int oscTypeNumber = 13;
+	std::string popupText[oscTypeNumber] = {"Sine", "Square", "Triangle", "Saw_Dig", "White noise", "Pink noise", "Brownian noise",
+		"Square (wavetable)", "Triangle (wavetable)", "Saw (wavetable)", "Square (PolyBLEP)", "Triangle (PolyBLEP)", "Saw (PolyBLEP)"};
 
 	OscNode(IDManager* idManager = nullptr)
 	{
@@ -432,13 +434,7 @@ struct ADSR_Node : public Node {
 	void assignToAudioComponent(AudioComponent* audioComponent) const override
 	{
 		ADSR* adsr = dynamic_cast<ADSR*>(audioComponent); assert(adsr);
-		for (int i = 0; i < 8; i++)
-			adsr->reference.controlPoints[i] = controlPoints[i];
-		for (auto& envelope : adsr->envelopes)
-		{
-			for (int i = 0; i < 8; i++)
-				envelope.envelope.controlPoints[i] = controlPoints[i];
-		}
+		adsr->setControlPoints(controlPoints);
 	}
 
 	void render(std::queue<Message>& messages) override
@@ -458,7 +454,7 @@ struct ADSR_Node : public Node {
 		const ADSR* adsr = dynamic_cast<const ADSR*>(component); assert(adsr);
 		bool controlPointsMatch = true;
 		for (int i = 0; i < 8; i++)
-			if (controlPoints[i] != adsr->reference.controlPoints[i])
+			if (controlPoints[i] != adsr->shape.controlPoints[i])
 				controlPointsMatch = false;
 		return Node::operator==(component) && controlPointsMatch;
 	}
@@ -571,8 +567,6 @@ struct SoundFontPlayerNode : public Node {
 		{
 			soundFontFilepath = node.soundFontFilepath;
 			needToUpdateSoundFontFile = true;
-			if (soundFont.loadSoundFontFile(soundFontFilepath, audioInfos.sampleRate))
-				soundFontFilepath.clear();
 		}
 	}
 
@@ -581,23 +575,42 @@ struct SoundFontPlayerNode : public Node {
 		Node::startRender();
 		Node::renderNameAndPins();
 
+		// Files are loaded in the background, the previous soundfont keeps playing meanwhile
 		if (needToUpdateSoundFontFile)
 		{
 			needToUpdateSoundFontFile = false;
-			if (soundFont.loadSoundFontFile(soundFontFilepath, audioInfos.sampleRate))
-				soundFontFilepath.clear();
+			soundFont.loadSoundFontFile(soundFontFilepath);
+		}
+
+		// The player gets its own instance, it stays valid whatever happens to this node
+		if (soundFont.isLoading() && soundFont.isLoadFinished() && soundFont.finishLoading())
+		{
+			soundFontFilepath = soundFont.getFilepath();
 			if (audioComponent)
-				((SoundFontPlayer*)audioComponent)->tinySoundFont = nullptr;
+			{
+				std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+				((SoundFontPlayer*)audioComponent)->setSoundFont(SoundFontCache::share(soundFont.getSoundFont()));
+			}
 		}
 
-		if (audioComponent && ((SoundFontPlayer*)audioComponent)->tinySoundFont == nullptr)
-			((SoundFontPlayer*)audioComponent)->tinySoundFont = soundFont.getSoundFont();
+		if (audioComponent && ((SoundFontPlayer*)audioComponent)->tinySoundFont == nullptr && soundFont.getSoundFont() != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+			((SoundFontPlayer*)audioComponent)->setSoundFont(SoundFontCache::share(soundFont.getSoundFont()));
+		}
 
 		ImGui::PushID(appendId("LoadSoundFontButton").c_str());
 		if (ImGui::Button("Load SoundFont"))
 			messages.push(Message(UI_SHOW_FILE_BROWSER, new FileBrowserOpenData({"Load SoundFont file", {".sf2"}, id})));
 		ImGui::PopID();
-		ImGui::Text("Current file: %s", fs::path(soundFontFilepath).filename().string().c_str());
+
+		if (soundFont.isLoading())
+		{
+			ImGui::Text("Loading: %s", fs::path(soundFontFilepath).filename().string().c_str());
+			ImGui::ProgressBar(soundFont.getLoadingProgress(), ImVec2(150, 0));
+		}
+		else
+			ImGui::Text("Current file: %s", fs::path(soundFontFilepath).filename().string().c_str());
 
 		Node::endRender();
 	}
@@ -2,23 +2,44 @@
 
 Audio::Audio(unsigned int sampleRate, unsigned int channels, unsigned int bufferDuration, unsigned int latency)
 	: _sampleRate(sampleRate), _channels(channels), _bufferDuration(bufferDuration), _latency(latency),
-	_targetFPS(60), _buffer(nullptr), _leftPhase(0), _rightPhase(1), _writeCursor(0), _syncCursors(false),
-	_samplesToAdjust(0), _time(0.0)
+	_targetFPS(60), _snapshotCursor(0), _frameClock(0), _clockOrigin(0.0),
+	_renderThreadRunning(false), _instruments(nullptr)
 {
 	initBuffer();
 	initOutputDevice(0); // Open system default audio device
-
-	std::this_thread::sleep_for(std::chrono::milliseconds(100)); // let rtaudio get more stable
-
-	// Read cursors might have already moved, so make write cursor point ahead of it.
-	_writeCursor = (_leftPhase + getLatencyInSamplesPerUpdate()) % getBufferSize();
 }
 
 Audio::~Audio()
 {
+	stopRenderThread();
 	stopAndCloseStreamIfExist();
 }
 
+void Audio::startRenderThread(std::vector<Instrument>& instruments)
+{
+	stopRenderThread();
+
+	_instruments = &instruments;
+	_renderThreadRunning = true;
+	_renderThread = std::thread(&Audio::renderLoop, this);
+}
+
+void Audio::stopRenderThread()
+{
+	if (!_renderThread.joinable())
+		return;
+
+	_renderThreadRunning = false;
+	_renderCondition.notify_one();
+	_renderThread.join();
+}
+
+void Audio::publishKeyPressed(const VoicePool& keyPressed)
+{
+	std::lock_guard<std::mutex> lock(_keyPressedMutex);
+	_publishedKeyPressed = keyPressed;
+}
+
 void Audio::stopAndCloseStreamIfExist()
 {
 	if (_stream.isStreamRunning())
@@ -33,18 +54,12 @@ void Audio::initBuffer()
 	if (_stream.isStreamRunning())
 		_stream.abortStream();
 
-	_buffer = std::make_unique<float[]>(getBufferSize());
-	if (_buffer == nullptr)
-	{
-		Logger::log("Audio", Error) << "Failed to allocate buffer (size: " << std::to_string(getBufferSize()) << ")" << std::endl;
-		exit(1);
-	}
-
-	std::memset((void*)_buffer.get(), 0, sizeof(float) * getBufferSize());
+	_buffer.resize(_sampleRate * _bufferDuration * _channels);
+	_renderBuffer.resize(getMaxRenderFrames() * _channels);
 
-	_leftPhase = 0;
-	_rightPhase = 1;
-	_writeCursor = (_leftPhase + getLatencyInSamplesPerUpdate()) % getBufferSize();
+	_playedBuffer.resize(_buffer.getCapacity());
+	_snapshot.assign(_buffer.getCapacity(), 0.0f);
+	_snapshotCursor = 0;
 }
 
 bool Audio::initOutputDevice(unsigned int deviceId)
@@ -82,6 +97,7 @@ bool Audio::initOutputDevice(unsigned int deviceId)
 	Logger::log("Audio", Info)  << "Sample rate: " << _stream.getStreamSampleRate() << "Hz" << std::endl;
 	Logger::log("Audio", Info)  << "Channel number: " << _channels << std::endl;
 	Logger::log("Audio", Info)  << "Buffer duration: " << _bufferDuration << " second(s)" << std::endl;
+	Logger::log("Audio", Info)  << "Vector kernels: " << Simd::getLevelName(Simd::getLevel()) << std::endl;
 
 	_sampleRate = _stream.getStreamSampleRate();
 	_deviceInfo = _stream.getDeviceInfo(parameters.deviceId);
@@ -89,36 +105,99 @@ bool Audio::initOutputDevice(unsigned int deviceId)
 	return false;
 }
 
-void Audio::update(std::vector<Instrument>& instruments, std::vector<MidiInfo>& keyPressed)
+void Audio::renderLoop()
 {
-	std::chrono::duration<double> frameDuration(1.0 / static_cast<double>(_sampleRate));
+	// Wake up at least once per callback period in case a notification is missed
+	const std::chrono::duration<double> callbackPeriod(1.0 / static_cast<double>(_targetFPS));
 
-	const int samplesToGenerate = static_cast<int>(getSamplesPerUpdate()) + _samplesToAdjust;
+	Simd::disableDenormals();
 
-	for (int i = 0; i < samplesToGenerate; i++)
+	while (_renderThreadRunning)
 	{
-		double value = 0.0;
+		{
+			std::unique_lock<std::mutex> lock(_renderMutex);
+			_renderCondition.wait_for(lock, callbackPeriod, [this]() { return !_renderThreadRunning || getFramesToRender() > 0; });
+		}
+
+		const unsigned int frames = std::min(getFramesToRender(), getMaxRenderFrames());
+		if (_renderThreadRunning && frames > 0)
+			render(frames);
+	}
+}
 
-		const AudioInfos audioInfos = {
-			.sampleRate = _sampleRate,
-			.channels = _channels
-		};
+unsigned int Audio::getFramesToRender()
+{
+	const unsigned int targetFrames = getLatencyInSamplesPerUpdate() / _channels;
+	const unsigned int bufferedFrames = (_buffer.getCapacity() - _buffer.writeAvailable()) / _channels;
 
-		for (Instrument& instrument : instruments)
-			value += instrument.process(audioInfos, keyPressed) * 1.0;
+	// Frames are rendered by multiples of CONTROL_RATE_FRAMES so components processed at control rate stay in time
+	const unsigned int missingFrames = std::min(bufferedFrames < targetFrames ? targetFrames - bufferedFrames : 0,
+		static_cast<unsigned int>(_buffer.writeAvailable() / _channels));
+	return missingFrames - missingFrames % CONTROL_RATE_FRAMES;
+}
 
-		_time += 1.0 / static_cast<double>(_sampleRate);
-		AudioComponent::time = _time;
+// Render at most one update worth of samples at a time, so the UI does not wait too long on the graph lock.
+// Rounded up to a multiple of CONTROL_RATE_FRAMES, _renderBuffer is sized for it.
+unsigned int Audio::getMaxRenderFrames() const
+{
+	const unsigned int frames = std::max(static_cast<unsigned int>(getSamplesPerUpdate()), static_cast<unsigned int>(CONTROL_RATE_FRAMES));
+	return (frames + CONTROL_RATE_FRAMES - 1) / CONTROL_RATE_FRAMES * CONTROL_RATE_FRAMES;
+}
 
-		for (int j = 0; j < _channels; j++)
+void Audio::render(unsigned int frames)
+{
+	{
+		std::lock_guard<std::mutex> lock(_keyPressedMutex);
+		_renderKeyPressed = _publishedKeyPressed;
+	}
+
+	const AudioInfos audioInfos = {
+		.sampleRate = _sampleRate,
+		.channels = _channels
+	};
+
+	// Graph must not be edited by the UI while it is processed
+	std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+
+	StereoBlock mixBlock;
+	StereoBlock instrumentBlock;
+
+	float* output = _renderBuffer.data();
+	for (unsigned int frame = 0; frame < frames; frame += MAX_BLOCK_FRAMES)
+	{
+		const int blockFrames = std::min(frames - frame, static_cast<unsigned int>(MAX_BLOCK_FRAMES));
+
+		const double time = _clockOrigin + static_cast<double>(_frameClock) / _sampleRate;
+
+		std::fill(mixBlock.begin(), mixBlock.begin() + 2 * blockFrames, 0.0f);
+		for (Instrument& instrument : *_instruments)
 		{
-			_buffer[_writeCursor] = std::clamp(value, -1.0, 1.0);
-			incrementWriteCursor();
+			instrument.processBlock(audioInfos, _renderKeyPressed, time, instrumentBlock.data(), blockFrames);
+			Simd::add(mixBlock.data(), instrumentBlock.data(), 2 * blockFrames);
+		}
+
+		_frameClock += blockFrames;
+
+		// Interleaved in the output buffer, mono devices play the average of both channels.
+		// With more than two channels, left and right alternate.
+		for (int i = 0; i < blockFrames; i++)
+		{
+			const float left = std::clamp(mixBlock[i], -1.0f, 1.0f);
+			const float right = std::clamp(mixBlock[blockFrames + i], -1.0f, 1.0f);
+			if (_channels == 1)
+			{
+				*output++ = 0.5f * (left + right);
+				continue;
+			}
+			for (unsigned int j = 0; j < _channels; j++)
+				*output++ = j % 2 == 0 ? left : right;
 		}
 	}
 
-	//assert(audio.syncCursors == false && "Audio callback did not reset syncCursors");
-	_syncCursors = true;
+	// getFramesToRender never asks for more frames than the buffer has room for, and the render thread is its only writer
+	const size_t written = _buffer.write(_renderBuffer.data(), frames * _channels);
+	assert(written == frames * _channels);
+	(void)written;
 }
 
 int Audio::uploadBuffer(void *outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void *userData)
@@ -132,44 +211,30 @@ int Audio::uploadBuffer(void *outputBuffer, void* inputBuffer, unsigned int nBuf
 
 	audio->copyBufferData(buffer, nBufferFrames, audio->mute);
 
-	if (audio->_syncCursors)
-	{
-		audio->_syncCursors = false;
-		int cursorsDelta = audio->_writeCursor - audio->_leftPhase;
-		if (cursorsDelta < 0)
-			cursorsDelta += audio->getBufferSize();
-
-		audio->_samplesToAdjust = audio->getLatencyInSamplesPerUpdate() - cursorsDelta;
-	}
+	// Let the render thread refill what was just consumed
+	audio->_renderCondition.notify_one();
 
 	return 0;
 }
 
 void Audio::copyBufferData(float* data, unsigned int sampleNumber, bool mute)
 {
-	for (int sample = 0; sample < sampleNumber; sample++)
-	{
-		*data++ = mute ? 0 : _buffer[_leftPhase];
-		if (_channels == 2)
-			*data++ = mute ? 0 : _buffer[_rightPhase];
-		incrementPhases();
-	}
-}
+	const unsigned int samplesRequested = sampleNumber * _channels;
+	const unsigned int samplesRead = mute ? _buffer.skip(samplesRequested) : _buffer.read(data, samplesRequested);
 
-unsigned int Audio::getBufferSize() const
-{
-	return _sampleRate * _bufferDuration * _channels;
-}
+	if (mute)
+		std::memset(data, 0, sizeof(float) * samplesRequested);
+	else if (samplesRead < samplesRequested) // Render thread is late, output silence instead of old samples
+		std::memset(data + samplesRead, 0, sizeof(float) * (samplesRequested - samplesRead));
 
-void Audio::incrementPhases()
-{
-	_leftPhase = (_leftPhase + _channels) % getBufferSize();
-	_rightPhase = (_rightPhase + _channels) % getBufferSize();
+	// Whole callbacks are dropped when the UI does not keep up, so channels stay interleaved
+	if (_playedBuffer.writeAvailable() >= samplesRequested)
+		_playedBuffer.write(data, samplesRequested);
 }
 
-void Audio::incrementWriteCursor()
+unsigned int Audio::getBufferSize() const
 {
-	_writeCursor = (_writeCursor + 1) % getBufferSize();
+	return _buffer.getCapacity();
 }
 
 double Audio::getSamplesPerUpdate() const
@@ -190,7 +255,7 @@ bool Audio::setLatency(unsigned int bufferFrameOffset)
 	const double durationInSeconds = bufferFrameOffset * getSamplesPerUpdate() / _sampleRate;
 
 	// Arbitrary limits
-	if (bufferFrameOffset > 30 || bufferFrameOffset == 0)
+	if (bufferFrameOffset > MAX_LATENCY || bufferFrameOffset == 0)
 	{
 		Logger::log("Audio", Warning) << "Invalid latency: " << bufferFrameOffset << " (" << durationInSeconds << " seconds)" << std::endl;
 		return true;
@@ -204,7 +269,7 @@ bool Audio::setLatency(unsigned int bufferFrameOffset)
 
 unsigned int Audio::getLatencyInSamplesPerUpdate() const
 {
-	return _latency * getSamplesPerUpdate() * _channels;
+	return _latency.load() * getSamplesPerUpdate() * _channels;
 }
 
 bool Audio::setChannelNumber(unsigned int channelNumber)
@@ -212,9 +277,13 @@ bool Audio::setChannelNumber(unsigned int channelNumber)
 	if (channelNumber == _channels)
 		return false;
 
+	stopRenderThread();
 	_channels = channelNumber;
 	initBuffer();
-	return initOutputDevice(_deviceInfo.ID);
+	const bool error = initOutputDevice(_deviceInfo.ID);
+	if (_instruments)
+		startRenderThread(*_instruments);
+	return error;
 }
 
 unsigned int Audio::getChannels() const
@@ -232,14 +301,20 @@ bool Audio::setSampleRate(unsigned int sampleRate)
 	if (sampleRate == _sampleRate)
 		return false;
 
+	stopRenderThread();
+	_clockOrigin += static_cast<double>(_frameClock) / _sampleRate;
+	_frameClock = 0;
 	_sampleRate = sampleRate;
 	initBuffer();
-	return initOutputDevice(_deviceInfo.ID);
+	const bool error = initOutputDevice(_deviceInfo.ID);
+	if (_instruments)
+		startRenderThread(*_instruments);
+	return error;
 }
 
 unsigned int Audio::getWriteCursorPos() const
 {
-	return _writeCursor;
+	return _buffer.getWriteIndex();
 }
 
 unsigned int Audio::getReadCursorPos(const unsigned int& cursor) const
@@ -249,12 +324,24 @@ unsigned int Audio::getReadCursorPos(const unsigned int& cursor) const
 		Logger::log("Audio", Error) << "cursor should be 0 (left phase) or 1 (right phase)" << std::endl;
 		exit(1);
 	}
-	return cursor == 0 ? _leftPhase : _rightPhase;
+	return (_buffer.getReadIndex() + cursor) & (_buffer.getCapacity() - 1);
+}
+
+void Audio::updateSnapshot()
+{
+	size_t samplesRead;
+	while ((samplesRead = _playedBuffer.read(_snapshot.data() + _snapshotCursor, _snapshot.size() - _snapshotCursor)) > 0)
+		_snapshotCursor = (_snapshotCursor + samplesRead) & (_snapshot.size() - 1);
+}
+
+const float* Audio::getSnapshot() const
+{
+	return _snapshot.data();
 }
 
-const float* Audio::getBuffer() const
+unsigned int Audio::getSnapshotCursorPos() const
 {
-	return _buffer.get();
+	return _snapshotCursor;
 }
 
 unsigned int Audio::getTargetFPS() const
@@ -274,7 +361,11 @@ RtAudio::DeviceInfo Audio::getDeviceInfo(unsigned int id)
 
 bool Audio::setAudioDevice(unsigned int deviceId)
 {
-	return initOutputDevice(deviceId);
+	stopRenderThread();
+	const bool error = initOutputDevice(deviceId);
+	if (_instruments)
+		startRenderThread(*_instruments);
+	return error;
 }
 
 const RtAudio::DeviceInfo& Audio::getUsedDeviceInfo() const
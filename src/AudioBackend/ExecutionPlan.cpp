@@ -0,0 +1,805 @@
+#include "AudioBackend/ExecutionPlan.hpp"
+
+#include <algorithm>
+#include "AudioBackend/Components/Multiplier.hpp"
+#include "AudioBackend/Components/KeyboardFrequency.hpp"
+
+void ExecutionPlan::compile(AudioComponent* master, unsigned int sampleRate)
+{
+	const size_t previousComponentCount = _componentCount;
+	const size_t previousScheduledCount = _scheduledCount;
+	const size_t previousControlRateCount = _controlRateCount;
+	const size_t previousNoteInvariantCount = _noteInvariantCount;
+	clear();
+
+	std::unordered_map<AudioComponent*, VisitState> visitState;
+	std::vector<AudioComponent*> order;
+	sortComponents(master, visitState, order);
+
+	// Only links to components sorted before their consumer are kept, this drops the links closing a cycle
+	std::unordered_map<AudioComponent*, size_t> position;
+	std::vector<PlanNode> nodes(order.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		PlanNode& node = nodes[i];
+		node.component = order[i];
+		node.gated = node.component->isVoiceGate();
+		node.sources.resize(node.component->inputs.size());
+		position[node.component] = i;
+
+		for (size_t inputIndex = 0; inputIndex < node.component->inputs.size(); inputIndex++)
+		{
+			for (AudioComponent* source : node.component->inputs[inputIndex])
+			{
+				auto it = position.find(source);
+				if (it == position.end())
+					continue;
+				node.sources[inputIndex].push_back(it->second);
+				node.gated = node.gated || nodes[it->second].gated;
+			}
+		}
+	}
+
+	const size_t masterIndex = order.size() - 1; // Master is sorted after all its inputs
+	optimize(nodes);
+	findNoteInvariantNodes(nodes, masterIndex);
+	findControlRateNodes(nodes, masterIndex);
+	findGates(nodes, masterIndex);
+	findStereoNodes(nodes, masterIndex);
+
+	// Constants are shared by every voice, other components get one block per voice and per channel.
+	// The mono blocks of downmixed stereo components follow their stereo blocks.
+	std::vector<size_t> offsets(nodes.size(), 0);
+	size_t arenaSize = 0;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		offsets[i] = arenaSize;
+		if (i == masterIndex || nodes[i].alias >= 0 || nodes[i].absorbed)
+			continue;
+		arenaSize += (nodes[i].constant ? 1 : MAX_VOICES) * MAX_BLOCK_FRAMES * (nodes[i].channels + (nodes[i].downmixed ? 1 : 0));
+	}
+
+	_arena.assign(arenaSize, 0.0f);
+	auto getBlock = [&](size_t index) { return _arena.data() + offsets[index]; };
+	auto getDownmix = [&](size_t index) { return nodes[index].downmixed ? getBlock(index) + MAX_VOICES * MAX_BLOCK_FRAMES * 2 : nullptr; };
+	auto getSource = [&](size_t index) {
+		const PlanNode& node = nodes[index];
+		return BlockSource{ getBlock(index), node.constant ? 0 : static_cast<size_t>(MAX_BLOCK_FRAMES * node.channels), node.controlRate, node.channels };
+	};
+	// Source read by a mono consumer
+	auto getMonoSource = [&](size_t index) { return nodes[index].downmixed ? BlockSource{ getDownmix(index), MAX_BLOCK_FRAMES } : getSource(index); };
+
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (nodes[i].constant)
+			std::fill(getBlock(i), getBlock(i) + MAX_BLOCK_FRAMES, nodes[i].value);
+	}
+
+	// Consumers come after their sources, so walking backward propagates what released voices need
+	std::vector<bool> neededOnRelease(nodes.size(), false);
+	for (size_t source : getReleaseSources(nodes, nodes[masterIndex].sources[0]))
+		neededOnRelease[source] = true;
+
+	for (size_t i = masterIndex; i-- > 0;)
+	{
+		const PlanNode& node = nodes[i];
+		if (!neededOnRelease[i] || node.constant || node.alias >= 0 || node.absorbed)
+			continue;
+
+		if (node.factorized)
+		{
+			for (size_t factor : node.factors)
+				neededOnRelease[factor] = true;
+			continue;
+		}
+
+		for (const std::vector<size_t>& sources : node.sources)
+		{
+			for (size_t source : getReleaseSources(nodes, sources))
+				neededOnRelease[source] = true;
+		}
+	}
+
+	// Blocks of the note invariant components read by scheduled ones are filled on every block
+	std::vector<bool> readByScheduled(nodes.size(), false);
+	for (size_t i = 0; i <= masterIndex; i++)
+	{
+		const PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		for (const std::vector<size_t>& sources : node.sources)
+		{
+			for (size_t source : sources)
+				readByScheduled[source] = true;
+		}
+		for (size_t factor : node.factors)
+			readByScheduled[factor] = true;
+	}
+
+	// Hand its input blocks to every scheduled component
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		const PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed)
+			continue;
+
+		AudioComponent* component = node.component;
+		component->inputSources.assign(node.sources.size(), {});
+		component->releaseInputSources.assign(node.sources.size(), {});
+		component->constantInputs.assign(node.sources.size(), std::nullopt);
+		component->noteConstantInputs.assign(node.sources.size(), false);
+
+		for (size_t inputIndex = 0; inputIndex < node.sources.size(); inputIndex++)
+		{
+			const std::vector<size_t>& sources = node.sources[inputIndex];
+			for (size_t source : sources)
+				component->inputSources[inputIndex].push_back(getMonoSource(source));
+			for (size_t source : getReleaseSources(nodes, sources))
+				component->releaseInputSources[inputIndex].push_back(getMonoSource(source));
+
+			if (sources.empty())
+				component->constantInputs[inputIndex] = 0.0f;
+			else if (sources.size() == 1 && nodes[sources[0]].constant)
+				component->constantInputs[inputIndex] = nodes[sources[0]].value;
+
+			component->noteConstantInputs[inputIndex] = std::all_of(sources.begin(), sources.end(),
+				[&](size_t source) { return nodes[source].constant || nodes[source].noteInvariant; });
+		}
+
+		// Summed, resampled and control rate inputs need a scratch block per lane.
+		// They are only sized here, the render thread must never allocate them.
+		bool needsScratch = false;
+		bool hasControlRateInput = false;
+		for (size_t inputIndex = 0; inputIndex < node.sources.size(); inputIndex++)
+		{
+			for (const std::vector<BlockSource>* sources : { &component->inputSources[inputIndex], &component->releaseInputSources[inputIndex] })
+			{
+				needsScratch |= sources->size() > 1;
+				for (const BlockSource& source : *sources)
+					needsScratch |= source.controlRate != node.controlRate;
+			}
+			hasControlRateInput |= component->getInputRate(inputIndex) != AudioRate;
+		}
+		component->inputBlocks.resize(needsScratch || hasControlRateInput ? component->inputs.size() * MAX_VOICES : 0);
+		// Smoothers are kept so the values changed by this compilation are ramped to
+		component->controlSmoothers.resize(hasControlRateInput ? component->inputs.size() * MAX_VOICES : 0);
+		component->prepare(sampleRate);
+
+		Multiplier* multiplier = dynamic_cast<Multiplier*>(component);
+		if (multiplier)
+		{
+			multiplier->factorized = node.factorized;
+			multiplier->gain = node.gain;
+			multiplier->channels = node.channels;
+			multiplier->factors.clear();
+			for (size_t factor : node.factors)
+				multiplier->factors.push_back(node.channels == 2 ? getSource(factor) : getMonoSource(factor));
+
+			// Factors leading to an envelope gate the others
+			multiplier->gates.clear();
+			for (size_t factor : node.factors)
+			{
+				if (node.gate >= 0 && nodes[factor].gated)
+					multiplier->gates.push_back(getMonoSource(factor));
+			}
+		}
+
+		if (node.noteInvariant)
+			_noteSchedule.push_back({ component, getBlock(i), readByScheduled[i], {} });
+	}
+
+	// Components are scheduled from the ones master reads, gates being checked before the branches they gate.
+	// Components whose output became useless after optimization are left out.
+	std::vector<bool> visited(nodes.size(), false);
+	std::vector<std::pair<size_t, bool>> scheduleOrder;
+	for (size_t source : nodes[masterIndex].sources[0])
+		sortSchedule(nodes, source, visited, scheduleOrder);
+	for (const auto& [index, gateCheck] : scheduleOrder)
+	{
+		const PlanNode& node = nodes[index];
+		_schedule.push_back({ node.component, getBlock(index), neededOnRelease[index], node.controlRate, gateCheck ? node.gate : -1, node.gates,
+			gateCheck ? nullptr : getDownmix(index) });
+		if (!gateCheck && node.component->hasVoiceTails())
+			_voiceTails.push_back(node.component);
+	}
+
+	int gateCount = 0;
+	for (const PlanNode& node : nodes)
+		gateCount = std::max(gateCount, node.gate + 1);
+	_closedGates.assign(gateCount, VoiceMask());
+	_openVoices.reserve(MAX_VOICES);
+
+	for (size_t source : nodes[masterIndex].sources[0])
+		_masterSources.push_back(getSource(source));
+	for (size_t source : getReleaseSources(nodes, nodes[masterIndex].sources[0]))
+		_masterReleaseSources.push_back(getSource(source));
+
+	_componentCount = masterIndex;
+	// Gate checks are extra steps, and gates left out of the schedule have no check
+	_scheduledCount = std::count_if(_schedule.begin(), _schedule.end(), [](const Step& step) { return step.gateCheck < 0; });
+	_controlRateCount = std::count_if(_schedule.begin(), _schedule.end(), [](const Step& step) { return step.controlRate && step.gateCheck < 0; });
+	_noteInvariantCount = _noteSchedule.size();
+	if (_componentCount != previousComponentCount || _scheduledCount != previousScheduledCount
+		|| _controlRateCount != previousControlRateCount || _noteInvariantCount != previousNoteInvariantCount)
+		Logger::log("ExecutionPlan", Info) << "Components: " << _componentCount << ", scheduled after optimization: " << _scheduledCount
+			<< ", at control rate: " << _controlRateCount << ", once per note: " << _noteInvariantCount << std::endl;
+}
+
+void ExecutionPlan::optimize(std::vector<PlanNode>& nodes)
+{
+	const size_t nodeCount = nodes.size(); // Constants created while optimizing are appended after
+
+	for (size_t i = 0; i < nodeCount; i++)
+	{
+		// Simplifying may append constants to nodes, do not keep references to its elements meanwhile
+		for (size_t inputIndex = 0; inputIndex < nodes[i].sources.size(); inputIndex++)
+		{
+			std::vector<size_t> sources = nodes[i].sources[inputIndex];
+			simplifySources(nodes, sources);
+			nodes[i].sources[inputIndex] = sources;
+		}
+
+		if (i == nodeCount - 1) // Master
+			break;
+
+		// Fold constant subtrees
+		std::vector<std::optional<float>> inputValues;
+		for (const std::vector<size_t>& sources : nodes[i].sources)
+		{
+			if (sources.empty())
+				inputValues.push_back(0.0f);
+			else if (sources.size() == 1 && nodes[sources[0]].constant)
+				inputValues.push_back(nodes[sources[0]].value);
+			else
+				inputValues.push_back(std::nullopt);
+		}
+
+		float value;
+		if (nodes[i].component->getConstantOutput(inputValues, value))
+		{
+			nodes[i].constant = true;
+			nodes[i].value = value;
+		}
+		else if (Multiplier* multiplier = dynamic_cast<Multiplier*>(nodes[i].component))
+		{
+			// Summed products are mono, the factorization of the previous compilation must not make them stereo
+			multiplier->factorized = false;
+			factorizeMultiplier(nodes, nodes[i]);
+		}
+	}
+
+	mergeMultipliers(nodes);
+}
+
+// Bypasses aliases, drops constant zeros and sums the remaining constants into a single one
+void ExecutionPlan::simplifySources(std::vector<PlanNode>& nodes, std::vector<size_t>& sources)
+{
+	std::vector<size_t> simplifiedSources;
+	std::vector<size_t> constants;
+	float constantsSum = 0.0f;
+
+	for (size_t source : sources)
+	{
+		source = resolve(nodes, source);
+		if (!nodes[source].constant)
+			simplifiedSources.push_back(source);
+		else if (nodes[source].value != 0.0f)
+		{
+			constants.push_back(source);
+			constantsSum += nodes[source].value;
+		}
+	}
+
+	if (constants.size() == 1)
+		simplifiedSources.push_back(constants[0]);
+	else if (constants.size() > 1)
+	{
+		PlanNode constant;
+		constant.component = nullptr;
+		constant.constant = true;
+		constant.value = constantsSum;
+		nodes.push_back(constant);
+		simplifiedSources.push_back(nodes.size() - 1);
+	}
+
+	sources = simplifiedSources;
+}
+
+void ExecutionPlan::factorizeMultiplier(std::vector<PlanNode>& nodes, PlanNode& node)
+{
+	float gain = 1.0f;
+	std::vector<size_t> factors;
+
+	for (const std::vector<size_t>& sources : node.sources)
+	{
+		if (sources.size() != 1) // Summed inputs are left to getInputsBlock
+			return;
+
+		if (nodes[sources[0]].constant)
+			gain *= nodes[sources[0]].value;
+		else
+			factors.push_back(sources[0]);
+	}
+
+	if (gain == 1.0f && factors.size() == 1) // Multiplication by one
+	{
+		node.alias = factors[0];
+		return;
+	}
+
+	node.factorized = true;
+	node.gain = gain;
+	node.factors = factors;
+}
+
+// Multipliers only feeding another multiplier are merged into it
+void ExecutionPlan::mergeMultipliers(std::vector<PlanNode>& nodes)
+{
+	std::vector<int> consumers(nodes.size(), 0);
+	for (const PlanNode& node : nodes)
+	{
+		if (node.constant || node.alias >= 0)
+			continue;
+		for (const std::vector<size_t>& sources : node.sources)
+		{
+			for (size_t source : sources)
+				consumers[source]++;
+		}
+	}
+
+	for (PlanNode& node : nodes)
+	{
+		if (!node.factorized)
+			continue;
+
+		std::vector<size_t> factors;
+		for (size_t factor : node.factors)
+		{
+			PlanNode& factorNode = nodes[factor];
+			if (factorNode.factorized && consumers[factor] == 1)
+			{
+				factorNode.absorbed = true;
+				node.gain *= factorNode.gain;
+				factors.insert(factors.end(), factorNode.factors.begin(), factorNode.factors.end());
+			}
+			else
+				factors.push_back(factor);
+		}
+		node.factors = factors;
+	}
+}
+
+// Components depending only on the note whose sources are all constants or note invariant themselves.
+// Sources come before their consumers, so walking forward decides every source before its consumers.
+void ExecutionPlan::findNoteInvariantNodes(std::vector<PlanNode>& nodes, size_t masterIndex)
+{
+	auto isNoteValue = [&](size_t index) { return nodes[index].constant || nodes[index].noteInvariant; };
+
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || !node.component->dependsOnlyOnNote())
+			continue;
+
+		if (node.factorized)
+		{
+			node.noteInvariant = std::all_of(node.factors.begin(), node.factors.end(), isNoteValue);
+			continue;
+		}
+
+		node.noteInvariant = true;
+		for (const std::vector<size_t>& sources : node.sources)
+			node.noteInvariant = node.noteInvariant && std::all_of(sources.begin(), sources.end(), isNoteValue);
+	}
+}
+
+/*
+ * Envelopes ignore their input while closed, and a multiplier by a factor leading to an envelope ignores its other factors
+ * while that factor is silent. Components only read through such gated sources, directly or through other such components,
+ * are skipped by the voices the gate is closed for.
+ * Components rendering every note on the first lane, and their consumers, are never gated: the gate of the first voice
+ * would silence every note.
+*/
+void ExecutionPlan::findGates(std::vector<PlanNode>& nodes, size_t masterIndex)
+{
+	// Sources come before their consumers
+	std::vector<bool> everyNote(nodes.size(), false);
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		const PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		const std::vector<size_t> reads = getReads(node);
+		everyNote[i] = node.component->rendersEveryNote() || std::any_of(reads.begin(), reads.end(), [&](size_t source) { return everyNote[source]; });
+	}
+
+	int gateCount = 0;
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		const int gatedInput = node.component->getGatedInput();
+		if (gatedInput >= 0 && !node.factorized && gatedInput < static_cast<int>(node.sources.size()))
+			node.gatedSources = node.sources[gatedInput];
+		else if (node.factorized)
+		{
+			const bool hasGatingFactor = std::any_of(node.factors.begin(), node.factors.end(), [&](size_t factor) { return nodes[factor].gated; });
+			for (size_t factor : node.factors)
+			{
+				if (hasGatingFactor && !nodes[factor].gated)
+					node.gatedSources.push_back(factor);
+			}
+		}
+		node.gatedSources.erase(std::remove_if(node.gatedSources.begin(), node.gatedSources.end(),
+			[&](size_t source) { return everyNote[source]; }), node.gatedSources.end());
+
+		if (!node.gatedSources.empty())
+			node.gate = gateCount++;
+	}
+
+	// Who reads each node, and whether the reader ignores it while its gate is closed
+	std::vector<std::vector<std::pair<size_t, bool>>> consumers(nodes.size());
+	for (size_t i = 0; i <= masterIndex; i++)
+	{
+		const PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		for (size_t source : getReads(node))
+		{
+			const bool gatedRead = std::find(node.gatedSources.begin(), node.gatedSources.end(), source) != node.gatedSources.end();
+			consumers[source].push_back({ i, gatedRead });
+		}
+	}
+
+	// Consumers come after their sources, so walking backward from the gate decides every consumer before its sources
+	for (size_t gate = 0; gate < masterIndex; gate++)
+	{
+		if (nodes[gate].gate < 0)
+			continue;
+
+		std::vector<bool> skipped(nodes.size(), false);
+		for (size_t i = gate; i-- > 0;)
+		{
+			PlanNode& node = nodes[i];
+			if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant || consumers[i].empty())
+				continue;
+
+			skipped[i] = std::all_of(consumers[i].begin(), consumers[i].end(), [&](const std::pair<size_t, bool>& consumer) {
+				return skipped[consumer.first] || (consumer.first == gate && consumer.second);
+			});
+			if (skipped[i])
+				node.gates.push_back(nodes[gate].gate);
+		}
+	}
+}
+
+// Nodes whose output is read by node (once processed, factorized multipliers only read their factors)
+std::vector<size_t> ExecutionPlan::getReads(const PlanNode& node) const
+{
+	if (node.factorized)
+		return node.factors;
+
+	std::vector<size_t> reads;
+	for (const std::vector<size_t>& sources : node.sources)
+		reads.insert(reads.end(), sources.begin(), sources.end());
+	return reads;
+}
+
+// Depth first, sources are scheduled before their consumers. Gates are checked once their other sources are processed.
+void ExecutionPlan::sortSchedule(const std::vector<PlanNode>& nodes, size_t index, std::vector<bool>& visited, std::vector<std::pair<size_t, bool>>& order) const
+{
+	const PlanNode& node = nodes[index];
+	if (visited[index] || node.constant || node.noteInvariant)
+		return;
+	visited[index] = true;
+
+	const std::vector<size_t> reads = getReads(node);
+	auto isGated = [&](size_t source) { return std::find(node.gatedSources.begin(), node.gatedSources.end(), source) != node.gatedSources.end(); };
+
+	for (size_t source : reads)
+	{
+		if (!isGated(source))
+			sortSchedule(nodes, source, visited, order);
+	}
+
+	if (node.gate >= 0)
+	{
+		order.push_back({ index, true });
+		for (size_t source : node.gatedSources)
+			sortSchedule(nodes, source, visited, order);
+	}
+
+	order.push_back({ index, false });
+}
+
+// Factorized multipliers processed at audio rate are stereo when one of their factors is, other components only output their own channels.
+// Stereo outputs read by mono consumers are downmixed.
+void ExecutionPlan::findStereoNodes(std::vector<PlanNode>& nodes, size_t masterIndex)
+{
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		if (node.factorized)
+			node.channels = !node.controlRate && std::any_of(node.factors.begin(), node.factors.end(), [&](size_t factor) { return nodes[factor].channels == 2; }) ? 2 : 1;
+		else
+			node.channels = node.component->getOutputChannels();
+	}
+
+	for (size_t i = 0; i < masterIndex; i++)
+	{
+		const PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant || node.channels == 2)
+			continue;
+
+		for (size_t source : getReads(node))
+			nodes[source].downmixed = nodes[source].downmixed || nodes[source].channels == 2;
+	}
+}
+
+// Components read at audio rate by any of their consumers are processed at audio rate.
+// Consumers come after their sources, so walking backward decides every consumer before its sources.
+void ExecutionPlan::findControlRateNodes(std::vector<PlanNode>& nodes, size_t masterIndex)
+{
+	std::vector<bool> readAtAudioRate(nodes.size(), false);
+	for (size_t i = masterIndex + 1; i-- > 0;)
+	{
+		PlanNode& node = nodes[i];
+		if (node.constant || node.alias >= 0 || node.absorbed || node.noteInvariant)
+			continue;
+
+		if (i != masterIndex)
+			node.controlRate = !readAtAudioRate[i] && node.component->supportsControlRate();
+
+		if (node.factorized)
+		{
+			for (size_t factor : node.factors)
+				readAtAudioRate[factor] = readAtAudioRate[factor] || !node.controlRate;
+			continue;
+		}
+
+		for (size_t inputIndex = 0; inputIndex < node.sources.size(); inputIndex++)
+		{
+			const bool controlRateInput = node.controlRate || (i != masterIndex && node.component->getInputRate(inputIndex) != AudioRate);
+			for (size_t source : node.sources[inputIndex])
+				readAtAudioRate[source] = readAtAudioRate[source] || !controlRateInput;
+		}
+	}
+}
+
+size_t ExecutionPlan::resolve(const std::vector<PlanNode>& nodes, size_t index) const
+{
+	while (nodes[index].alias >= 0)
+		index = nodes[index].alias;
+	return index;
+}
+
+// On inputs mixing envelope branches with other components, released voices only read the envelope branches
+std::vector<size_t> ExecutionPlan::getReleaseSources(const std::vector<PlanNode>& nodes, const std::vector<size_t>& sources) const
+{
+	bool hasGatedSource = false;
+	for (size_t source : sources)
+		hasGatedSource = hasGatedSource || nodes[source].gated;
+
+	if (!hasGatedSource)
+		return sources;
+
+	std::vector<size_t> releaseSources;
+	for (size_t source : sources)
+	{
+		if (nodes[source].gated)
+			releaseSources.push_back(source);
+	}
+	return releaseSources;
+}
+
+void ExecutionPlan::sortComponents(AudioComponent* component, std::unordered_map<AudioComponent*, VisitState>& visitState, std::vector<AudioComponent*>& order)
+{
+	auto it = visitState.find(component);
+	if (it != visitState.end())
+	{
+		if (it->second == Visiting)
+			Logger::log("ExecutionPlan", Warning) << "Cycle detected on " << component->componentName << " " << component->id << ", link ignored." << std::endl;
+		return;
+	}
+
+	visitState[component] = Visiting;
+	for (const ComponentInput& input : component->inputs)
+	{
+		for (AudioComponent* source : input)
+			sortComponents(source, visitState, order);
+	}
+	visitState[component] = Visited;
+	order.push_back(component);
+}
+
+void ExecutionPlan::clear()
+{
+	_schedule.clear();
+	_noteSchedule.clear();
+	_noteValuesReady.reset();
+	_voiceTails.clear();
+	_arena.clear();
+	_masterSources.clear();
+	_masterReleaseSources.clear();
+}
+
+void ExecutionPlan::startBlock()
+{
+	for (Step& step : _schedule)
+		step.component->startBlock();
+}
+
+void ExecutionPlan::resetVoice(int voice)
+{
+	for (Step& step : _schedule)
+	{
+		step.component->resetControls(voice);
+		step.component->resetVoice(voice);
+	}
+	for (NoteStep& step : _noteSchedule)
+	{
+		step.component->resetControls(voice);
+		step.component->resetVoice(voice);
+	}
+	_noteValuesReady.reset(voice);
+	_voiceLevels[voice] = 0.0f;
+	_silentBlocks[voice] = 0;
+}
+
+void ExecutionPlan::run(const AudioInfos& audioInfos, VoiceContext* voices, int voiceCount, float* out, int frames)
+{
+	if (voiceCount == 0)
+		return;
+
+	const bool released = voices[0].isReleased();
+	const double deltaTime = voices[0].deltaTime;
+	const int controlFrames = (frames + CONTROL_RATE_FRAMES - 1) / CONTROL_RATE_FRAMES;
+
+	if (_frequenciesVersion != KeyboardFrequency::frequenciesVersion)
+	{
+		_frequenciesVersion = KeyboardFrequency::frequenciesVersion;
+		_noteValuesReady.reset();
+	}
+
+	for (int lane = 0; lane < voiceCount; lane++)
+	{
+		if (!_noteValuesReady[voices[lane].voice])
+			computeNoteValues(audioInfos, voices[lane]);
+	}
+
+	for (const NoteStep& step : _noteSchedule)
+	{
+		if (!step.filled)
+			continue;
+		for (int lane = 0; lane < voiceCount; lane++)
+		{
+			float* block = step.output + lane * MAX_BLOCK_FRAMES;
+			std::fill(block, block + frames, step.values[voices[lane].voice]);
+		}
+	}
+
+	auto setFrameStride = [&](int frameStride) {
+		for (int i = 0; i < voiceCount; i++)
+		{
+			voices[i].frameStride = frameStride;
+			voices[i].deltaTime = deltaTime * frameStride;
+		}
+	};
+
+	for (Step& step : _schedule)
+	{
+		if (released && !step.runOnRelease)
+			continue;
+
+		const int stepFrames = step.controlRate ? controlFrames : frames;
+		if (step.controlRate)
+			setFrameStride(CONTROL_RATE_FRAMES);
+
+		// Lanes for which a gate of the step is closed
+		VoiceMask skipped;
+		for (int gate : step.gates)
+			skipped |= _closedGates[gate];
+
+		if (step.gateCheck >= 0)
+		{
+			// Gates inside a skipped branch are closed too
+			VoiceMask& closed = _closedGates[step.gateCheck];
+			closed = skipped;
+			for (int lane = 0; lane < voiceCount; lane++)
+			{
+				if (!skipped[lane] && step.component->isGateClosed(audioInfos, voices[lane], stepFrames))
+					closed.set(lane);
+			}
+		}
+		else if (skipped.none())
+			step.component->processVoices(audioInfos, voices, voiceCount, step.output, stepFrames);
+		else
+		{
+			_openVoices.clear();
+			for (int lane = 0; lane < voiceCount; lane++)
+			{
+				if (skipped[lane])
+					step.component->skipBlock(audioInfos, voices[lane], stepFrames);
+				else
+					_openVoices.push_back(voices[lane]);
+			}
+			if (!_openVoices.empty())
+				step.component->processVoices(audioInfos, _openVoices.data(), _openVoices.size(), step.output, stepFrames);
+		}
+
+		if (step.downmix)
+		{
+			for (int lane = 0; lane < voiceCount; lane++)
+			{
+				if (skipped[lane])
+					continue;
+				const float* left = step.output + lane * MAX_BLOCK_FRAMES * 2;
+				float* mono = step.downmix + lane * MAX_BLOCK_FRAMES;
+				for (int i = 0; i < frames; i++)
+					mono[i] = 0.5f * (left[i] + left[frames + i]);
+			}
+		}
+
+		if (step.controlRate)
+			setFrameStride(1);
+	}
+
+	// Mono sources are added to both channels
+	const std::vector<BlockSource>& masterSources = released ? _masterReleaseSources : _masterSources;
+	for (int lane = 0; lane < voiceCount; lane++)
+	{
+		float level = 0.0f;
+		for (const BlockSource& source : masterSources)
+		{
+			float sourceLevel = 0.0f;
+			for (int channel = 0; channel < 2; channel++)
+			{
+				const float* block = source.getChannel(lane, channel, frames);
+				float* channelOut = out + channel * frames;
+				if (channel < source.channels)
+					sourceLevel = std::max(sourceLevel, Simd::peak(block, frames));
+
+				if (!voices[lane].fading)
+				{
+					Simd::add(channelOut, block, frames);
+					continue;
+				}
+
+				// Stolen voice, ramp down to avoid a click
+				for (int i = 0; i < frames; i++)
+					channelOut[i] += block[i] * (1.0f - static_cast<float>(i + 1) / frames);
+			}
+			level += sourceLevel;
+		}
+		const int voice = voices[lane].voice;
+		_voiceLevels[voice] = level;
+		_silentBlocks[voice] = level > SILENCE_THRESHOLD ? 0 : _silentBlocks[voice] + 1;
+	}
+}
+
+// Evaluates the note invariant components for a single frame of the voice, their sources being evaluated before them
+void ExecutionPlan::computeNoteValues(const AudioInfos& audioInfos, VoiceContext& context)
+{
+	for (NoteStep& step : _noteSchedule)
+	{
+		float* block = step.output + context.lane * MAX_BLOCK_FRAMES;
+		step.component->processBlock(audioInfos, context, block, 1);
+		step.values[context.voice] = block[0];
+	}
+	_noteValuesReady.set(context.voice);
+}
+
+void ExecutionPlan::getVoiceTails(VoiceMask& tails) const
+{
+	tails.reset();
+	for (const AudioComponent* component : _voiceTails)
+		component->getVoiceTails(tails);
+}
@@ -1,6 +1,9 @@
 #include "AudioBackend/Instrument.hpp"
 
-double Instrument::process(const AudioInfos& audioInfos, std::vector<MidiInfo>& keyPressed)
+void Instrument::processBlock(const AudioInfos& audioInfos, const VoicePool& keyPressed, double time, float* out, int frames)
 {
-	return master.process(audioInfos, keyPressed) * volume;
+	VoiceContext context = { keyPressed, nullptr, 0, 0, false, time, 1.0 / static_cast<double>(audioInfos.sampleRate) };
+	master.processBlock(audioInfos, context, out, frames);
+
+	Simd::scale(out, out, volume, 2 * frames);
 }
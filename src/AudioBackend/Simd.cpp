@@ -0,0 +1,1112 @@
+#include "AudioBackend/Simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "config.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#define SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are built with a target attribute, the rest of the program keeps the baseline instruction set
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+	#define SIMD_AVX2
+	#define AVX2_TARGET __attribute__((target("avx2")))
+	#include <immintrin.h>
+#endif
+
+namespace Simd {
+
+/*
+ * Approximations of each precision, coefficients are listed from the lowest degree.
+ *
+ * tanh: Lambert continued fraction, clamped where it reaches 1. Error < 1.5e-3 (Fast), < 1e-4 (Accurate).
+ * sin: minimax polynomial of sin(x) / x in x^2 on [-pi/2, pi/2]. Error < 7e-5 (Fast), < 1e-6 (Accurate).
+ * exp2: 2^x = 2^n * 2^f with n the integer part, minimax polynomial of 2^f on [0, 1]. Relative error < 1.1e-4 (Fast), < 3e-7 (Accurate).
+*/
+static constexpr float TANH_FAST_LIMIT = 3.6468f;
+static constexpr float TANH_FAST_NUMERATOR[] = { 945.0f, 105.0f, 1.0f };
+static constexpr float TANH_FAST_DENOMINATOR[] = { 945.0f, 420.0f, 15.0f };
+static constexpr float TANH_LIMIT = 4.97f;
+static constexpr float TANH_NUMERATOR[] = { 135135.0f, 17325.0f, 378.0f, 1.0f };
+static constexpr float TANH_DENOMINATOR[] = { 135135.0f, 62370.0f, 3150.0f, 28.0f };
+
+static constexpr float SIN_FAST[] = { 0.99969728557f, -0.16567408144f, 0.00751475085f };
+static constexpr float SIN[] = { 0.99999661963f, -0.16664829706f, 0.00830633671f, -0.00018363934f };
+
+static constexpr float EXP2_FAST[] = { 0.99989204056f, 0.69646232072f, 0.22433396410f, 0.07920374092f };
+static constexpr float EXP2[] = { 0.99999989273f, 0.69315476041f, 0.24013967645f, 0.05586629597f, 0.00894281025f, 0.00189645695f };
+static constexpr float EXP2_MIN = -126.0f, EXP2_MAX = 127.99f; // Normal float range
+
+static constexpr float PI = 3.14159265358979f;
+static constexpr float HALF_PI = PI / 2.0f;
+
+/*
+ * Noise filters run on chunks of four frames so that they vectorize over frames. Scalar kernels use the same chunks
+ * and the same operation order, every level renders bit-identical noise.
+ *
+ * Pink: Paul Kellet's refined filter, three one pole filters y[n] = a * y[n - 1] + c * x[n] of the white noise, plus part of it.
+ * Over a chunk, y[n + i] = sum(a^(i - j) * c * x[n + j], j <= i) + a^(i + 1) * y[n - 1]: every output is a weighted
+ * sum of the four inputs and of the three states before the chunk.
+ * Brown: integration of the white noise bounded to [-1, 1], a prefix sum over chunks that cannot reach the bounds.
+*/
+static constexpr int NOISE_CHUNK = 4;
+static constexpr int PINK_POLE_COUNT = 3;
+static constexpr double PINK_POLES[] = { 0.99765, 0.96300, 0.57000 };
+static constexpr double PINK_GAINS[] = { 0.0990460 / 20.0, 0.2965164 / 20.0, 1.0526913 / 20.0 }; // The filter is loud, it is divided by 20
+static constexpr double PINK_DIRECT_GAIN = 0.1848 / 20.0;
+static constexpr float BROWN_STEP = 0.02f;
+
+struct PinkChunkWeights {
+	float inputs[NOISE_CHUNK][NOISE_CHUNK]; // Weight of input j in output i
+	float states[PINK_POLE_COUNT][NOISE_CHUNK]; // Weight of the state of pole k in output i
+	float nextInputs[NOISE_CHUNK][NOISE_CHUNK]; // Weight of input j in the state of pole k after the chunk, last lane unused
+	float nextStates[NOISE_CHUNK]; // Weight of the state of pole k in its state after the chunk
+};
+
+static PinkChunkWeights buildPinkChunkWeights()
+{
+	PinkChunkWeights weights = {};
+	for (int k = 0; k < PINK_POLE_COUNT; k++)
+	{
+		for (int i = 0; i < NOISE_CHUNK; i++)
+		{
+			for (int j = 0; j <= i; j++)
+				weights.inputs[j][i] += static_cast<float>(PINK_GAINS[k] * std::pow(PINK_POLES[k], i - j));
+			weights.states[k][i] = static_cast<float>(std::pow(PINK_POLES[k], i + 1));
+			weights.nextInputs[i][k] = static_cast<float>(PINK_GAINS[k] * std::pow(PINK_POLES[k], NOISE_CHUNK - 1 - i));
+		}
+		weights.nextStates[k] = static_cast<float>(std::pow(PINK_POLES[k], NOISE_CHUNK));
+	}
+	for (int i = 0; i < NOISE_CHUNK; i++)
+		weights.inputs[i][i] += static_cast<float>(PINK_DIRECT_GAIN);
+	return weights;
+}
+
+static const PinkChunkWeights PINK_WEIGHTS = buildPinkChunkWeights();
+
+// ----------------- SCALAR -----------------
+
+namespace scalar {
+
+template<size_t N>
+static float horner(float x, const float (&coefficients)[N])
+{
+	float result = coefficients[N - 1];
+	for (int i = N - 2; i >= 0; i--)
+		result = coefficients[i] + x * result;
+	return result;
+}
+
+template<Precision P>
+static float tanh(float x)
+{
+	x = std::clamp(x, -(P == Fast ? TANH_FAST_LIMIT : TANH_LIMIT), P == Fast ? TANH_FAST_LIMIT : TANH_LIMIT);
+	const float x2 = x * x;
+	float result;
+	if constexpr (P == Fast)
+		result = x * horner(x2, TANH_FAST_NUMERATOR) / horner(x2, TANH_FAST_DENOMINATOR);
+	else
+		result = x * horner(x2, TANH_NUMERATOR) / horner(x2, TANH_DENOMINATOR);
+	return std::clamp(result, -1.0f, 1.0f);
+}
+
+// Brings the phase back in [-pi/2, pi/2] where sin(x) = sin(folded) and asin(sin(x)) = folded
+static float fold(float phase)
+{
+	if (phase > HALF_PI)
+		return PI - phase;
+	if (phase < -HALF_PI)
+		return -PI - phase;
+	return phase;
+}
+
+template<Precision P>
+static float sin(float phase)
+{
+	const float x = fold(phase);
+	return x * (P == Fast ? horner(x * x, SIN_FAST) : horner(x * x, SIN));
+}
+
+template<Precision P>
+static float exp2(float x)
+{
+	x = std::clamp(x, EXP2_MIN, EXP2_MAX);
+	int n = static_cast<int>(x);
+	n -= n > x; // Truncation rounds negative values up
+	const float f = x - n;
+
+	float power;
+	const uint32_t bits = static_cast<uint32_t>(n + 127) << 23;
+	std::memcpy(&power, &bits, sizeof(power));
+	return power * (P == Fast ? horner(f, EXP2_FAST) : horner(f, EXP2));
+}
+
+static void multiply(float* out, const float* a, const float* b, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = a[i] * b[i];
+}
+
+static void scale(float* out, const float* a, float gain, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = gain * a[i];
+}
+
+static void add(float* out, const float* a, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] += a[i];
+}
+
+static float peak(const float* a, int frames)
+{
+	float result = 0.0f;
+	for (int i = 0; i < frames; i++)
+		result = std::max(result, std::abs(a[i]));
+	return result;
+}
+
+template<Precision P>
+static void tanhMultiply(float* out, const float* a, const float* b, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = tanh<P>(a[i] * b[i]);
+}
+
+template<Precision P>
+static void tanhScale(float* out, const float* a, float gain, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = tanh<P>(a[i] * gain);
+}
+
+template<Precision P>
+static void sine(float* out, const float* phases, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = sin<P>(phases[i]);
+}
+
+template<Precision P>
+static void exp2(float* out, const float* a, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = exp2<P>(a[i]);
+}
+
+static void square(float* out, const float* phases, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = phases[i] > 0.0f ? 1.0f : -1.0f;
+}
+
+static void triangle(float* out, const float* phases, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = fold(phases[i]) * (1.0f / HALF_PI);
+}
+
+static uint32_t xorshift(uint32_t x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	return x ^ (x << 5);
+}
+
+static void whiteNoise(float* out, uint32_t* states, int frames)
+{
+	for (int i = 0; i < frames; i++)
+	{
+		uint32_t& state = states[i % NOISE_LANES];
+		state = xorshift(state);
+		out[i] = static_cast<float>(static_cast<int32_t>(state)) * (1.0f / 2147483648.0f);
+	}
+}
+
+static void pinkNoise(float* out, const float* white, float* state, int frames)
+{
+	int i = 0;
+	for (; i + NOISE_CHUNK <= frames; i += NOISE_CHUNK)
+	{
+		float result[NOISE_CHUNK], next[NOISE_CHUNK];
+		for (int lane = 0; lane < NOISE_CHUNK; lane++)
+		{
+			result[lane] = white[i] * PINK_WEIGHTS.inputs[0][lane];
+			for (int j = 1; j < NOISE_CHUNK; j++)
+				result[lane] = result[lane] + white[i + j] * PINK_WEIGHTS.inputs[j][lane];
+			for (int k = 0; k < PINK_POLE_COUNT; k++)
+				result[lane] = result[lane] + state[k] * PINK_WEIGHTS.states[k][lane];
+
+			// States are added last, the next chunk only waits for one multiplication and one addition
+			next[lane] = white[i] * PINK_WEIGHTS.nextInputs[0][lane];
+			for (int j = 1; j < NOISE_CHUNK; j++)
+				next[lane] = next[lane] + white[i + j] * PINK_WEIGHTS.nextInputs[j][lane];
+			next[lane] = next[lane] + state[lane] * PINK_WEIGHTS.nextStates[lane];
+		}
+		std::copy(result, result + NOISE_CHUNK, out + i);
+		std::copy(next, next + NOISE_CHUNK, state);
+	}
+
+	// Last frames of the block
+	for (; i < frames; i++)
+	{
+		for (int k = 0; k < PINK_POLE_COUNT; k++)
+			state[k] = static_cast<float>(PINK_POLES[k]) * state[k] + static_cast<float>(PINK_GAINS[k]) * white[i];
+		out[i] = state[0] + state[1] + state[2] + static_cast<float>(PINK_DIRECT_GAIN) * white[i];
+	}
+}
+
+static void brownNoise(float* out, const float* white, float* state, int frames, int firstFrame = 0)
+{
+	float value = *state;
+	for (int i = firstFrame; i < frames; i++)
+	{
+		// Chunks far enough from the bounds are a prefix sum, in the order of the vectorized kernels
+		if (i % NOISE_CHUNK == 0 && i + NOISE_CHUNK <= frames && std::abs(value) <= 1.0f - NOISE_CHUNK * BROWN_STEP)
+		{
+			float steps[NOISE_CHUNK], pairs[NOISE_CHUNK];
+			for (int lane = 0; lane < NOISE_CHUNK; lane++)
+				steps[lane] = BROWN_STEP * white[i + lane];
+			for (int lane = 0; lane < NOISE_CHUNK; lane++)
+				pairs[lane] = steps[lane] + (lane >= 1 ? steps[lane - 1] : 0.0f);
+			for (int lane = 0; lane < NOISE_CHUNK; lane++)
+				out[i + lane] = value + (pairs[lane] + (lane >= 2 ? pairs[lane - 2] : 0.0f));
+			value = out[i + NOISE_CHUNK - 1];
+			i += NOISE_CHUNK - 1;
+			continue;
+		}
+
+		value = std::clamp(value + BROWN_STEP * white[i], -1.0f, 1.0f);
+		out[i] = value;
+	}
+	*state = value;
+}
+
+static void stateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames, int firstFrame = 0)
+{
+	for (int v = 0; v < voiceCount; v++)
+	{
+		float lowValue = low[v];
+		float bandValue = band[v];
+		for (int i = firstFrame; i < frames; i++)
+		{
+			const float high = inputs[v][i] - lowValue - damping * bandValue;
+			bandValue += cutoff * high;
+			lowValue += cutoff * bandValue;
+			outputs[v][i] = highPass ? high : lowValue;
+		}
+		low[v] = lowValue;
+		band[v] = bandValue;
+	}
+}
+
+}
+
+// ----------------- SSE2 -----------------
+
+#ifdef SIMD_SSE2
+namespace sse2 {
+
+static __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+template<size_t N>
+static __m128 horner(__m128 x, const float (&coefficients)[N])
+{
+	__m128 result = _mm_set1_ps(coefficients[N - 1]);
+	for (int i = N - 2; i >= 0; i--)
+		result = _mm_add_ps(_mm_set1_ps(coefficients[i]), _mm_mul_ps(x, result));
+	return result;
+}
+
+template<Precision P>
+static __m128 tanh(__m128 x)
+{
+	const float limit = P == Fast ? TANH_FAST_LIMIT : TANH_LIMIT;
+	x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(limit)), _mm_set1_ps(-limit));
+	const __m128 x2 = _mm_mul_ps(x, x);
+
+	__m128 result;
+	if constexpr (P == Fast)
+		result = _mm_div_ps(_mm_mul_ps(x, horner(x2, TANH_FAST_NUMERATOR)), horner(x2, TANH_FAST_DENOMINATOR));
+	else
+		result = _mm_div_ps(_mm_mul_ps(x, horner(x2, TANH_NUMERATOR)), horner(x2, TANH_DENOMINATOR));
+	return _mm_max_ps(_mm_min_ps(result, _mm_set1_ps(1.0f)), _mm_set1_ps(-1.0f));
+}
+
+static __m128 fold(__m128 phase)
+{
+	const __m128 upper = _mm_sub_ps(_mm_set1_ps(PI), phase);
+	const __m128 lower = _mm_sub_ps(_mm_set1_ps(-PI), phase);
+	phase = select(_mm_cmpgt_ps(phase, _mm_set1_ps(HALF_PI)), upper, phase);
+	return select(_mm_cmplt_ps(phase, _mm_set1_ps(-HALF_PI)), lower, phase);
+}
+
+template<Precision P>
+static __m128 sin(__m128 phase)
+{
+	const __m128 x = fold(phase);
+	const __m128 x2 = _mm_mul_ps(x, x);
+	return _mm_mul_ps(x, P == Fast ? horner(x2, SIN_FAST) : horner(x2, SIN));
+}
+
+template<Precision P>
+static __m128 exp2(__m128 x)
+{
+	x = _mm_max_ps(_mm_min_ps(x, _mm_set1_ps(EXP2_MAX)), _mm_set1_ps(EXP2_MIN));
+
+	// Truncation rounds negative values up, floor is one less for them
+	__m128i n = _mm_cvttps_epi32(x);
+	const __m128 above = _mm_cmpgt_ps(_mm_cvtepi32_ps(n), x);
+	n = _mm_add_epi32(n, _mm_castps_si128(above)); // True lanes are -1
+	const __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(n));
+
+	const __m128 power = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+	return _mm_mul_ps(power, P == Fast ? horner(f, EXP2_FAST) : horner(f, EXP2));
+}
+
+static void multiply(float* out, const float* a, const float* b, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	scalar::multiply(out + i, a + i, b + i, frames - i);
+}
+
+static void scale(float* out, const float* a, float gain, int frames)
+{
+	const __m128 gainVector = _mm_set1_ps(gain);
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(gainVector, _mm_loadu_ps(a + i)));
+	scalar::scale(out + i, a + i, gain, frames - i);
+}
+
+static void add(float* out, const float* a, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(a + i)));
+	scalar::add(out + i, a + i, frames - i);
+}
+
+static float peak(const float* a, int frames)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 result = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		result = _mm_max_ps(result, _mm_and_ps(_mm_loadu_ps(a + i), signMask));
+
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, result);
+	return std::max({ lanes[0], lanes[1], lanes[2], lanes[3], scalar::peak(a + i, frames - i) });
+}
+
+template<Precision P>
+static void tanhMultiply(float* out, const float* a, const float* b, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, tanh<P>(_mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i))));
+	scalar::tanhMultiply<P>(out + i, a + i, b + i, frames - i);
+}
+
+template<Precision P>
+static void tanhScale(float* out, const float* a, float gain, int frames)
+{
+	const __m128 gainVector = _mm_set1_ps(gain);
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, tanh<P>(_mm_mul_ps(_mm_loadu_ps(a + i), gainVector)));
+	scalar::tanhScale<P>(out + i, a + i, gain, frames - i);
+}
+
+template<Precision P>
+static void sine(float* out, const float* phases, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, sin<P>(_mm_loadu_ps(phases + i)));
+	scalar::sine<P>(out + i, phases + i, frames - i);
+}
+
+template<Precision P>
+static void exp2(float* out, const float* a, int frames)
+{
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, exp2<P>(_mm_loadu_ps(a + i)));
+	scalar::exp2<P>(out + i, a + i, frames - i);
+}
+
+static void square(float* out, const float* phases, int frames)
+{
+	const __m128 positive = _mm_set1_ps(1.0f), negative = _mm_set1_ps(-1.0f);
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, select(_mm_cmpgt_ps(_mm_loadu_ps(phases + i), _mm_setzero_ps()), positive, negative));
+	scalar::square(out + i, phases + i, frames - i);
+}
+
+static void triangle(float* out, const float* phases, int frames)
+{
+	const __m128 gain = _mm_set1_ps(1.0f / HALF_PI);
+	int i = 0;
+	for (; i + 4 <= frames; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(fold(_mm_loadu_ps(phases + i)), gain));
+	scalar::triangle(out + i, phases + i, frames - i);
+}
+
+static __m128i xorshift(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+}
+
+static void whiteNoise(float* out, uint32_t* states, int frames)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states));
+	__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + 4));
+	int i = 0;
+	for (; i + NOISE_LANES <= frames; i += NOISE_LANES)
+	{
+		low = xorshift(low);
+		high = xorshift(high);
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(states), low);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(states + 4), high);
+	scalar::whiteNoise(out + i, states, frames - i);
+}
+
+// Same weighted sums as the scalar kernel, one chunk per vector
+static void pinkNoise(float* out, const float* white, float* state, int frames)
+{
+	__m128 inputs[NOISE_CHUNK], states[PINK_POLE_COUNT], nextInputs[NOISE_CHUNK];
+	for (int j = 0; j < NOISE_CHUNK; j++)
+	{
+		inputs[j] = _mm_loadu_ps(PINK_WEIGHTS.inputs[j]);
+		nextInputs[j] = _mm_loadu_ps(PINK_WEIGHTS.nextInputs[j]);
+	}
+	for (int k = 0; k < PINK_POLE_COUNT; k++)
+		states[k] = _mm_loadu_ps(PINK_WEIGHTS.states[k]);
+	const __m128 nextStates = _mm_loadu_ps(PINK_WEIGHTS.nextStates);
+
+	__m128 stateVector = _mm_loadu_ps(state);
+	int i = 0;
+	for (; i + NOISE_CHUNK <= frames; i += NOISE_CHUNK)
+	{
+		__m128 result = _mm_mul_ps(_mm_set1_ps(white[i]), inputs[0]);
+		__m128 next = _mm_mul_ps(_mm_set1_ps(white[i]), nextInputs[0]);
+		for (int j = 1; j < NOISE_CHUNK; j++)
+		{
+			const __m128 input = _mm_set1_ps(white[i + j]);
+			result = _mm_add_ps(result, _mm_mul_ps(input, inputs[j]));
+			next = _mm_add_ps(next, _mm_mul_ps(input, nextInputs[j]));
+		}
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(stateVector, stateVector, _MM_SHUFFLE(0, 0, 0, 0)), states[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(stateVector, stateVector, _MM_SHUFFLE(1, 1, 1, 1)), states[1]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(stateVector, stateVector, _MM_SHUFFLE(2, 2, 2, 2)), states[2]));
+		next = _mm_add_ps(next, _mm_mul_ps(stateVector, nextStates));
+
+		_mm_storeu_ps(out + i, result);
+		stateVector = next;
+	}
+	_mm_storeu_ps(state, stateVector);
+	scalar::pinkNoise(out + i, white + i, state, frames - i);
+}
+
+static void brownNoise(float* out, const float* white, float* state, int frames)
+{
+	const __m128 step = _mm_set1_ps(BROWN_STEP);
+	float value = *state;
+	int i = 0;
+	for (; i + NOISE_CHUNK <= frames; i += NOISE_CHUNK)
+	{
+		if (std::abs(value) > 1.0f - NOISE_CHUNK * BROWN_STEP)
+		{
+			*state = value;
+			scalar::brownNoise(out, white, state, i + NOISE_CHUNK, i);
+			value = *state;
+			continue;
+		}
+
+		// Prefix sum: lane i adds lane i - 1, then lane i - 2
+		const __m128 steps = _mm_mul_ps(step, _mm_loadu_ps(white + i));
+		const __m128 pairs = _mm_add_ps(steps, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(steps), 4)));
+		const __m128 sums = _mm_add_ps(pairs, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(pairs), 8)));
+		const __m128 result = _mm_add_ps(_mm_set1_ps(value), sums);
+		_mm_storeu_ps(out + i, result);
+		value = _mm_cvtss_f32(_mm_shuffle_ps(result, result, _MM_SHUFFLE(3, 3, 3, 3)));
+	}
+	*state = value;
+	scalar::brownNoise(out, white, state, frames, i);
+}
+
+/*
+ * Each lane holds one voice. Four frames of four voices are loaded as rows and transposed,
+ * so every vector then holds the same frame for the four voices and the filter runs once for all of them.
+*/
+static void stateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames)
+{
+	const __m128 cutoffVector = _mm_set1_ps(cutoff);
+	const __m128 dampingVector = _mm_set1_ps(damping);
+
+	// Missing voices of the last group read silence and write in a scratch block
+	alignas(16) static const float silence[MAX_BLOCK_FRAMES] = {};
+	alignas(16) float scratch[MAX_BLOCK_FRAMES];
+
+	int v = 0;
+	for (; v + 1 < voiceCount; v += 4) // A single voice has nothing to share a vector with
+	{
+		const int count = std::min(4, voiceCount - v);
+		const float* in[4];
+		float* out[4];
+		alignas(16) float lows[4] = {}, bands[4] = {};
+		for (int j = 0; j < 4; j++)
+		{
+			in[j] = j < count ? inputs[v + j] : silence;
+			out[j] = j < count ? outputs[v + j] : scratch;
+			if (j < count)
+			{
+				lows[j] = low[v + j];
+				bands[j] = band[v + j];
+			}
+		}
+
+		__m128 lowVector = _mm_load_ps(lows);
+		__m128 bandVector = _mm_load_ps(bands);
+
+		int i = 0;
+		for (; i + 4 <= frames; i += 4)
+		{
+			__m128 rows[4] = { _mm_loadu_ps(in[0] + i), _mm_loadu_ps(in[1] + i), _mm_loadu_ps(in[2] + i), _mm_loadu_ps(in[3] + i) };
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+
+			for (__m128& frame : rows)
+			{
+				const __m128 high = _mm_sub_ps(_mm_sub_ps(frame, lowVector), _mm_mul_ps(dampingVector, bandVector));
+				bandVector = _mm_add_ps(bandVector, _mm_mul_ps(cutoffVector, high));
+				lowVector = _mm_add_ps(lowVector, _mm_mul_ps(cutoffVector, bandVector));
+				frame = highPass ? high : lowVector;
+			}
+
+			_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+			for (int j = 0; j < 4; j++)
+				_mm_storeu_ps(out[j] + i, rows[j]);
+		}
+
+		_mm_store_ps(lows, lowVector);
+		_mm_store_ps(bands, bandVector);
+		scalar::stateVariableFilter(in, out, lows, bands, 4, cutoff, damping, highPass, frames, i);
+
+		for (int j = 0; j < count; j++)
+		{
+			low[v + j] = lows[j];
+			band[v + j] = bands[j];
+		}
+	}
+
+	scalar::stateVariableFilter(inputs + v, outputs + v, low + v, band + v, voiceCount - v, cutoff, damping, highPass, frames);
+}
+
+}
+#endif
+
+// ----------------- AVX2 -----------------
+
+#ifdef SIMD_AVX2
+namespace avx2 {
+
+/*
+ * Kernels clear the upper halves of the ymm registers (vzeroupper) before calling the scalar or SSE2 code
+ * handling their remaining frames. The compiler only does it when returning, not before these tail calls,
+ * and SSE code running with dirty upper halves (libm included) pays a transition penalty on every instruction.
+*/
+
+template<size_t N>
+AVX2_TARGET static __m256 horner(__m256 x, const float (&coefficients)[N])
+{
+	__m256 result = _mm256_set1_ps(coefficients[N - 1]);
+	for (int i = N - 2; i >= 0; i--)
+		result = _mm256_add_ps(_mm256_set1_ps(coefficients[i]), _mm256_mul_ps(x, result));
+	return result;
+}
+
+template<Precision P>
+AVX2_TARGET static __m256 tanh(__m256 x)
+{
+	const float limit = P == Fast ? TANH_FAST_LIMIT : TANH_LIMIT;
+	x = _mm256_max_ps(_mm256_min_ps(x, _mm256_set1_ps(limit)), _mm256_set1_ps(-limit));
+	const __m256 x2 = _mm256_mul_ps(x, x);
+
+	__m256 result;
+	if constexpr (P == Fast)
+		result = _mm256_div_ps(_mm256_mul_ps(x, horner(x2, TANH_FAST_NUMERATOR)), horner(x2, TANH_FAST_DENOMINATOR));
+	else
+		result = _mm256_div_ps(_mm256_mul_ps(x, horner(x2, TANH_NUMERATOR)), horner(x2, TANH_DENOMINATOR));
+	return _mm256_max_ps(_mm256_min_ps(result, _mm256_set1_ps(1.0f)), _mm256_set1_ps(-1.0f));
+}
+
+AVX2_TARGET static __m256 fold(__m256 phase)
+{
+	const __m256 upper = _mm256_sub_ps(_mm256_set1_ps(PI), phase);
+	const __m256 lower = _mm256_sub_ps(_mm256_set1_ps(-PI), phase);
+	phase = _mm256_blendv_ps(phase, upper, _mm256_cmp_ps(phase, _mm256_set1_ps(HALF_PI), _CMP_GT_OQ));
+	return _mm256_blendv_ps(phase, lower, _mm256_cmp_ps(phase, _mm256_set1_ps(-HALF_PI), _CMP_LT_OQ));
+}
+
+template<Precision P>
+AVX2_TARGET static __m256 sin(__m256 phase)
+{
+	const __m256 x = fold(phase);
+	const __m256 x2 = _mm256_mul_ps(x, x);
+	return _mm256_mul_ps(x, P == Fast ? horner(x2, SIN_FAST) : horner(x2, SIN));
+}
+
+template<Precision P>
+AVX2_TARGET static __m256 exp2(__m256 x)
+{
+	x = _mm256_max_ps(_mm256_min_ps(x, _mm256_set1_ps(EXP2_MAX)), _mm256_set1_ps(EXP2_MIN));
+	const __m256 floor = _mm256_floor_ps(x);
+	const __m256 f = _mm256_sub_ps(x, floor);
+
+	const __m256i n = _mm256_cvtps_epi32(floor);
+	const __m256 power = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23));
+	return _mm256_mul_ps(power, P == Fast ? horner(f, EXP2_FAST) : horner(f, EXP2));
+}
+
+AVX2_TARGET static void multiply(float* out, const float* a, const float* b, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	_mm256_zeroupper();
+	scalar::multiply(out + i, a + i, b + i, frames - i);
+}
+
+AVX2_TARGET static void scale(float* out, const float* a, float gain, int frames)
+{
+	const __m256 gainVector = _mm256_set1_ps(gain);
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(gainVector, _mm256_loadu_ps(a + i)));
+	_mm256_zeroupper();
+	scalar::scale(out + i, a + i, gain, frames - i);
+}
+
+AVX2_TARGET static void add(float* out, const float* a, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(a + i)));
+	_mm256_zeroupper();
+	scalar::add(out + i, a + i, frames - i);
+}
+
+AVX2_TARGET static float peak(const float* a, int frames)
+{
+	const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256 result = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		result = _mm256_max_ps(result, _mm256_and_ps(_mm256_loadu_ps(a + i), signMask));
+
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, result);
+	_mm256_zeroupper();
+	return std::max({ lanes[0], lanes[1], lanes[2], lanes[3], lanes[4], lanes[5], lanes[6], lanes[7], scalar::peak(a + i, frames - i) });
+}
+
+template<Precision P>
+AVX2_TARGET static void tanhMultiply(float* out, const float* a, const float* b, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, tanh<P>(_mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i))));
+	_mm256_zeroupper();
+	scalar::tanhMultiply<P>(out + i, a + i, b + i, frames - i);
+}
+
+template<Precision P>
+AVX2_TARGET static void tanhScale(float* out, const float* a, float gain, int frames)
+{
+	const __m256 gainVector = _mm256_set1_ps(gain);
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, tanh<P>(_mm256_mul_ps(_mm256_loadu_ps(a + i), gainVector)));
+	_mm256_zeroupper();
+	scalar::tanhScale<P>(out + i, a + i, gain, frames - i);
+}
+
+template<Precision P>
+AVX2_TARGET static void sine(float* out, const float* phases, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, sin<P>(_mm256_loadu_ps(phases + i)));
+	_mm256_zeroupper();
+	scalar::sine<P>(out + i, phases + i, frames - i);
+}
+
+template<Precision P>
+AVX2_TARGET static void exp2(float* out, const float* a, int frames)
+{
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, exp2<P>(_mm256_loadu_ps(a + i)));
+	_mm256_zeroupper();
+	scalar::exp2<P>(out + i, a + i, frames - i);
+}
+
+AVX2_TARGET static void square(float* out, const float* phases, int frames)
+{
+	const __m256 positive = _mm256_set1_ps(1.0f), negative = _mm256_set1_ps(-1.0f);
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+	{
+		const __m256 mask = _mm256_cmp_ps(_mm256_loadu_ps(phases + i), _mm256_setzero_ps(), _CMP_GT_OQ);
+		_mm256_storeu_ps(out + i, _mm256_blendv_ps(negative, positive, mask));
+	}
+	_mm256_zeroupper();
+	scalar::square(out + i, phases + i, frames - i);
+}
+
+AVX2_TARGET static void triangle(float* out, const float* phases, int frames)
+{
+	const __m256 gain = _mm256_set1_ps(1.0f / HALF_PI);
+	int i = 0;
+	for (; i + 8 <= frames; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(fold(_mm256_loadu_ps(phases + i)), gain));
+	_mm256_zeroupper();
+	scalar::triangle(out + i, phases + i, frames - i);
+}
+
+AVX2_TARGET static void whiteNoise(float* out, uint32_t* states, int frames)
+{
+	const __m256 scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+	__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states));
+	int i = 0;
+	for (; i + NOISE_LANES <= frames; i += NOISE_LANES)
+	{
+		x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+		x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+		x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(states), x);
+	_mm256_zeroupper();
+	scalar::whiteNoise(out + i, states, frames - i);
+}
+
+// Noise filters keep four frame chunks, eight frame chunks would not render the same noise as the other levels
+static void pinkNoise(float* out, const float* white, float* state, int frames)
+{
+#ifdef SIMD_SSE2
+	sse2::pinkNoise(out, white, state, frames);
+#else
+	scalar::pinkNoise(out, white, state, frames);
+#endif
+}
+
+static void brownNoise(float* out, const float* white, float* state, int frames)
+{
+#ifdef SIMD_SSE2
+	sse2::brownNoise(out, white, state, frames);
+#else
+	scalar::brownNoise(out, white, state, frames);
+#endif
+}
+
+AVX2_TARGET static void transpose(__m256* rows)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]), t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+	const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]), t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+	const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]), t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+	const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]), t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+	const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Same as the SSE2 version with eight voices per group
+AVX2_TARGET static void stateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames)
+{
+	const __m256 cutoffVector = _mm256_set1_ps(cutoff);
+	const __m256 dampingVector = _mm256_set1_ps(damping);
+
+	alignas(32) static const float silence[MAX_BLOCK_FRAMES] = {};
+	alignas(32) float scratch[MAX_BLOCK_FRAMES];
+
+	int v = 0;
+	for (; v + 4 < voiceCount; v += 8) // Up to four voices are left to the SSE2 kernel
+	{
+		const int count = std::min(8, voiceCount - v);
+		const float* in[8];
+		float* out[8];
+		alignas(32) float lows[8] = {}, bands[8] = {};
+		for (int j = 0; j < 8; j++)
+		{
+			in[j] = j < count ? inputs[v + j] : silence;
+			out[j] = j < count ? outputs[v + j] : scratch;
+			if (j < count)
+			{
+				lows[j] = low[v + j];
+				bands[j] = band[v + j];
+			}
+		}
+
+		__m256 lowVector = _mm256_load_ps(lows);
+		__m256 bandVector = _mm256_load_ps(bands);
+
+		int i = 0;
+		for (; i + 8 <= frames; i += 8)
+		{
+			__m256 rows[8];
+			for (int j = 0; j < 8; j++)
+				rows[j] = _mm256_loadu_ps(in[j] + i);
+			transpose(rows);
+
+			for (__m256& frame : rows)
+			{
+				const __m256 high = _mm256_sub_ps(_mm256_sub_ps(frame, lowVector), _mm256_mul_ps(dampingVector, bandVector));
+				bandVector = _mm256_add_ps(bandVector, _mm256_mul_ps(cutoffVector, high));
+				lowVector = _mm256_add_ps(lowVector, _mm256_mul_ps(cutoffVector, bandVector));
+				frame = highPass ? high : lowVector;
+			}
+
+			transpose(rows);
+			for (int j = 0; j < 8; j++)
+				_mm256_storeu_ps(out[j] + i, rows[j]);
+		}
+
+		_mm256_store_ps(lows, lowVector);
+		_mm256_store_ps(bands, bandVector);
+		_mm256_zeroupper();
+		scalar::stateVariableFilter(in, out, lows, bands, 8, cutoff, damping, highPass, frames, i);
+
+		for (int j = 0; j < count; j++)
+		{
+			low[v + j] = lows[j];
+			band[v + j] = bands[j];
+		}
+	}
+
+#ifdef SIMD_SSE2
+	_mm256_zeroupper();
+	sse2::stateVariableFilter(inputs + v, outputs + v, low + v, band + v, voiceCount - v, cutoff, damping, highPass, frames);
+#else
+	_mm256_zeroupper();
+	scalar::stateVariableFilter(inputs + v, outputs + v, low + v, band + v, voiceCount - v, cutoff, damping, highPass, frames);
+#endif
+}
+
+}
+#endif
+
+// ----------------- EXACT -----------------
+
+// libm, used as the reference of the approximations
+namespace exact {
+
+static void tanhMultiply(float* out, const float* a, const float* b, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = std::tanh(a[i] * b[i]);
+}
+
+static void tanhScale(float* out, const float* a, float gain, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = std::tanh(a[i] * gain);
+}
+
+static void sine(float* out, const float* phases, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = std::sin(phases[i]);
+}
+
+static void exp2(float* out, const float* a, int frames)
+{
+	for (int i = 0; i < frames; i++)
+		out[i] = std::exp2(a[i]);
+}
+
+}
+
+// ----------------- DISPATCH -----------------
+
+struct Kernels {
+	void (*multiply)(float*, const float*, const float*, int);
+	void (*scale)(float*, const float*, float, int);
+	void (*add)(float*, const float*, int);
+	float (*peak)(const float*, int);
+	void (*square)(float*, const float*, int);
+	void (*triangle)(float*, const float*, int);
+	void (*whiteNoise)(float*, uint32_t*, int);
+	void (*pinkNoise)(float*, const float*, float*, int);
+	void (*brownNoise)(float*, const float*, float*, int);
+	void (*stateVariableFilter)(const float* const*, float* const*, float*, float*, int, float, float, bool, int);
+};
+
+// Kernels approximating a function, one set per precision
+struct MathKernels {
+	void (*tanhMultiply)(float*, const float*, const float*, int);
+	void (*tanhScale)(float*, const float*, float, int);
+	void (*sine)(float*, const float*, int);
+	void (*exp2)(float*, const float*, int);
+};
+
+static Level detectLevel()
+{
+#ifdef SIMD_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return AVX2;
+#endif
+#ifdef SIMD_SSE2
+	return SSE2;
+#else
+	return Scalar;
+#endif
+}
+
+static void scalarStateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames)
+{
+	scalar::stateVariableFilter(inputs, outputs, low, band, voiceCount, cutoff, damping, highPass, frames);
+}
+
+static void scalarBrownNoise(float* out, const float* white, float* state, int frames)
+{
+	scalar::brownNoise(out, white, state, frames);
+}
+
+static Kernels selectKernels(Level level)
+{
+	switch (level)
+	{
+#ifdef SIMD_AVX2
+		case AVX2: return { avx2::multiply, avx2::scale, avx2::add, avx2::peak, avx2::square, avx2::triangle,
+			avx2::whiteNoise, avx2::pinkNoise, avx2::brownNoise, avx2::stateVariableFilter };
+#endif
+#ifdef SIMD_SSE2
+		case SSE2: return { sse2::multiply, sse2::scale, sse2::add, sse2::peak, sse2::square, sse2::triangle,
+			sse2::whiteNoise, sse2::pinkNoise, sse2::brownNoise, sse2::stateVariableFilter };
+#endif
+		default: return { scalar::multiply, scalar::scale, scalar::add, scalar::peak, scalar::square, scalar::triangle,
+			scalar::whiteNoise, scalar::pinkNoise, scalarBrownNoise, scalarStateVariableFilter };
+	}
+}
+
+template<Precision P>
+static MathKernels selectMathKernels(Level level)
+{
+	switch (level)
+	{
+#ifdef SIMD_AVX2
+		case AVX2: return { avx2::tanhMultiply<P>, avx2::tanhScale<P>, avx2::sine<P>, avx2::exp2<P> };
+#endif
+#ifdef SIMD_SSE2
+		case SSE2: return { sse2::tanhMultiply<P>, sse2::tanhScale<P>, sse2::sine<P>, sse2::exp2<P> };
+#endif
+		default: return { scalar::tanhMultiply<P>, scalar::tanhScale<P>, scalar::sine<P>, scalar::exp2<P> };
+	}
+}
+
+static const Level level = detectLevel();
+static const Kernels kernels = selectKernels(level);
+static const MathKernels mathKernels[] = {
+	selectMathKernels<Fast>(level),
+	selectMathKernels<Accurate>(level),
+	{ exact::tanhMultiply, exact::tanhScale, exact::sine, exact::exp2 }
+};
+
+// Set by the UI, read by the render thread
+static std::atomic<Precision> precision(Accurate);
+
+Level getLevel() { return level; }
+
+const char* getLevelName(Level level)
+{
+	switch (level)
+	{
+		case AVX2: return "AVX2";
+		case SSE2: return "SSE2";
+		default: return "Scalar";
+	}
+}
+
+void setPrecision(Precision value) { precision.store(value, std::memory_order_relaxed); }
+Precision getPrecision() { return precision.load(std::memory_order_relaxed); }
+
+const char* getPrecisionName(Precision precision)
+{
+	switch (precision)
+	{
+		case Fast: return "Fast";
+		case Accurate: return "Accurate";
+		default: return "Exact";
+	}
+}
+
+// Decaying filter and delay states end up in denormal numbers, which are many times slower to compute with
+void disableDenormals()
+{
+#ifdef SIMD_SSE2
+	_mm_setcsr(_mm_getcsr() | 0x8040); // Flush to zero and denormals are zero
+#elif defined(__aarch64__) && defined(__GNUC__)
+	unsigned long fpcr;
+	__asm__ volatile("mrs %0, fpcr" : "=r"(fpcr));
+	__asm__ volatile("msr fpcr, %0" : : "r"(fpcr | (1ul << 24))); // Flush to zero
+#endif
+}
+
+void multiply(float* out, const float* a, const float* b, int frames) { kernels.multiply(out, a, b, frames); }
+void scale(float* out, const float* a, float gain, int frames) { kernels.scale(out, a, gain, frames); }
+void add(float* out, const float* a, int frames) { kernels.add(out, a, frames); }
+float peak(const float* a, int frames) { return kernels.peak(a, frames); }
+void tanhMultiply(float* out, const float* a, const float* b, int frames) { mathKernels[getPrecision()].tanhMultiply(out, a, b, frames); }
+void tanhScale(float* out, const float* a, float gain, int frames) { mathKernels[getPrecision()].tanhScale(out, a, gain, frames); }
+void sine(float* out, const float* phases, int frames) { mathKernels[getPrecision()].sine(out, phases, frames); }
+void exp2(float* out, const float* a, int frames) { mathKernels[getPrecision()].exp2(out, a, frames); }
+void square(float* out, const float* phases, int frames) { kernels.square(out, phases, frames); }
+void triangle(float* out, const float* phases, int frames) { kernels.triangle(out, phases, frames); }
+void whiteNoise(float* out, uint32_t* states, int frames) { kernels.whiteNoise(out, states, frames); }
+void pinkNoise(float* out, const float* white, float* state, int frames) { kernels.pinkNoise(out, white, state, frames); }
+void brownNoise(float* out, const float* white, float* state, int frames) { kernels.brownNoise(out, white, state, frames); }
+
+void stateVariableFilter(const float* const* inputs, float* const* outputs, float* low, float* band, int voiceCount,
+	float cutoff, float damping, bool highPass, int frames)
+{
+	kernels.stateVariableFilter(inputs, outputs, low, band, voiceCount, cutoff, damping, highPass, frames);
+}
+
+}
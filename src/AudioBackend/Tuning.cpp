@@ -0,0 +1,214 @@
+#include "AudioBackend/Tuning.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include "Logger.hpp"
+
+Tuning::Tuning()
+{
+	reset();
+}
+
+void Tuning::reset()
+{
+	_ratios.clear();
+	for (int semitone = 1; semitone <= 12; semitone++)
+		_ratios.push_back(std::exp2(semitone / 12.0));
+	_mapping = KeyboardMapping();
+	_frequencies = EQUAL_TEMPERAMENT;
+	_scaleName = "12-TET";
+	_mappingName = "Default";
+}
+
+bool Tuning::loadScale(const fs::path& filepath)
+{
+	std::vector<std::string> lines;
+	if (readLines(filepath, lines))
+		return true;
+
+	// First line is the description, followed by the degree count and one pitch per degree
+	int degreeCount = 0;
+	if (lines.size() < 2 || parseInteger(lines[1], degreeCount) || degreeCount <= 0 || lines.size() < 2 + static_cast<size_t>(degreeCount))
+	{
+		Logger::log("Tuning", Error) << "Invalid degree count in scale file: " << filepath.string() << std::endl;
+		return true;
+	}
+
+	std::vector<double> ratios(degreeCount);
+	for (int degree = 0; degree < degreeCount; degree++)
+	{
+		if (parsePitch(lines[2 + degree], ratios[degree]))
+		{
+			Logger::log("Tuning", Error) << "Invalid pitch \"" << lines[2 + degree] << "\" in scale file: " << filepath.string() << std::endl;
+			return true;
+		}
+	}
+
+	Table frequencies;
+	if (buildTable(ratios, _mapping, frequencies))
+	{
+		Logger::log("Tuning", Error) << "Reference note of the keyboard mapping is not mapped, scale not loaded: " << filepath.string() << std::endl;
+		return true;
+	}
+
+	_ratios = ratios;
+	_frequencies = frequencies;
+	_scaleName = lines[0].empty() ? filepath.filename().string() : lines[0];
+	Logger::log("Tuning", Info) << "Loaded scale \"" << _scaleName << "\" (" << degreeCount << " degrees)" << std::endl;
+	return false;
+}
+
+bool Tuning::loadKeyboardMapping(const fs::path& filepath)
+{
+	std::vector<std::string> lines;
+	if (readLines(filepath, lines))
+		return true;
+
+	// Size of the pattern, first and last retuned notes, middle note, reference note and frequency, octave degree, then the pattern
+	KeyboardMapping mapping;
+	int size = 0;
+	bool invalid = lines.size() < 7
+		|| parseInteger(lines[0], size) || size < 0
+		|| parseInteger(lines[1], mapping.firstNote) || parseInteger(lines[2], mapping.lastNote)
+		|| parseInteger(lines[3], mapping.middleNote) || parseInteger(lines[4], mapping.referenceNote)
+		|| parseInteger(lines[6], mapping.octaveDegree) || mapping.octaveDegree < 0;
+
+	if (!invalid)
+	{
+		char* end = nullptr;
+		mapping.referenceFrequency = std::strtod(lines[5].c_str(), &end);
+		invalid = end == lines[5].c_str() || !(mapping.referenceFrequency > 0.0);
+	}
+
+	for (int note : { mapping.firstNote, mapping.lastNote, mapping.middleNote, mapping.referenceNote })
+		invalid = invalid || note < 0 || note >= NOTE_COUNT;
+
+	// Missing entries at the end of the pattern are unmapped
+	for (int key = 0; !invalid && key < size; key++)
+	{
+		int degree = -1;
+		if (7 + static_cast<size_t>(key) < lines.size() && lines[7 + key].find_first_of("xX") == std::string::npos)
+			invalid = parseInteger(lines[7 + key], degree) || degree < 0;
+		mapping.degrees.push_back(degree);
+	}
+
+	if (invalid)
+	{
+		Logger::log("Tuning", Error) << "Invalid keyboard mapping file: " << filepath.string() << std::endl;
+		return true;
+	}
+
+	Table frequencies;
+	if (buildTable(_ratios, mapping, frequencies))
+	{
+		Logger::log("Tuning", Error) << "Reference note is not mapped in keyboard mapping file: " << filepath.string() << std::endl;
+		return true;
+	}
+
+	_mapping = mapping;
+	_frequencies = frequencies;
+	_mappingName = filepath.filename().string();
+	Logger::log("Tuning", Info) << "Loaded keyboard mapping \"" << _mappingName << "\" (reference note " << mapping.referenceNote
+		<< " at " << mapping.referenceFrequency << " Hz)" << std::endl;
+	return false;
+}
+
+bool Tuning::readLines(const fs::path& filepath, std::vector<std::string>& lines)
+{
+	std::ifstream file(filepath);
+	if (!file.is_open())
+	{
+		Logger::log("Tuning", Error) << "Could not open file: " << filepath.string() << std::endl;
+		return true;
+	}
+
+	// Comment lines are skipped, empty ones are kept as the scale description can be empty
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty() || line[0] != '!')
+			lines.push_back(line);
+	}
+	return false;
+}
+
+bool Tuning::parseInteger(const std::string& line, int& value)
+{
+	char* end = nullptr;
+	const long result = std::strtol(line.c_str(), &end, 10);
+	if (end == line.c_str())
+		return true;
+
+	value = static_cast<int>(result);
+	return false;
+}
+
+// Pitches containing a period are in cents, others are ratios ("3/2") or integers ("2"). Text after the value is a comment.
+bool Tuning::parsePitch(const std::string& line, double& ratio)
+{
+	const size_t start = line.find_first_not_of(" \t");
+	if (start == std::string::npos)
+		return true;
+
+	const size_t end = line.find_first_of(" \t", start);
+	const std::string value = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+	char* parseEnd = nullptr;
+	if (value.find('.') != std::string::npos)
+	{
+		const double cents = std::strtod(value.c_str(), &parseEnd);
+		ratio = std::exp2(cents / 1200.0);
+		return *parseEnd != '\0';
+	}
+
+	const double numerator = std::strtod(value.c_str(), &parseEnd);
+	double denominator = 1.0;
+	if (*parseEnd == '/')
+		denominator = std::strtod(parseEnd + 1, &parseEnd);
+
+	ratio = numerator / denominator;
+	return *parseEnd != '\0' || !(numerator > 0.0) || !(denominator > 0.0);
+}
+
+double Tuning::getDegreeRatio(const std::vector<double>& ratios, int degree)
+{
+	const int degreeCount = ratios.size();
+	const int period = degree >= 0 ? degree / degreeCount : (degree + 1) / degreeCount - 1; // Rounded down
+	const int index = degree - period * degreeCount;
+
+	const double ratio = index == 0 ? 1.0 : ratios[index - 1];
+	return ratio * std::pow(ratios.back(), period);
+}
+
+bool Tuning::buildTable(const std::vector<double>& ratios, const KeyboardMapping& mapping, Table& table)
+{
+	// Ratio of each note to the middle note, 0 when unmapped
+	std::array<double, NOTE_COUNT> noteRatios = {};
+	const int patternSize = mapping.degrees.size();
+	const double octaveRatio = getDegreeRatio(ratios, mapping.octaveDegree == 0 ? ratios.size() : mapping.octaveDegree);
+	for (int note = mapping.firstNote; note <= mapping.lastNote; note++)
+	{
+		const int offset = note - mapping.middleNote;
+		if (patternSize == 0)
+		{
+			noteRatios[note] = getDegreeRatio(ratios, offset);
+			continue;
+		}
+
+		const int repetition = offset >= 0 ? offset / patternSize : (offset + 1) / patternSize - 1; // Rounded down
+		const int degree = mapping.degrees[offset - repetition * patternSize];
+		if (degree != -1)
+			noteRatios[note] = getDegreeRatio(ratios, degree) * std::pow(octaveRatio, repetition);
+	}
+
+	const double referenceRatio = noteRatios[mapping.referenceNote];
+	if (referenceRatio == 0.0)
+		return true;
+
+	for (int note = 0; note < NOTE_COUNT; note++)
+		table[note] = static_cast<float>(mapping.referenceFrequency * noteRatios[note] / referenceRatio);
+	return false;
+}
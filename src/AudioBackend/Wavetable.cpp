@@ -0,0 +1,72 @@
+#include "AudioBackend/Wavetable.hpp"
+
+#include <cmath>
+
+// Built during static initialization, before the render thread starts
+const std::array<Wavetable, Wavetable::ShapeCount> Wavetable::_tables = Wavetable::buildTables();
+
+const Wavetable& Wavetable::get(Shape shape)
+{
+	return _tables[shape];
+}
+
+std::array<Wavetable, Wavetable::ShapeCount> Wavetable::buildTables()
+{
+	return { Wavetable(Square), Wavetable(Triangle), Wavetable(Saw) };
+}
+
+// Fourier series of the naive waveforms played by the oscillator, all of them only have sine terms
+double Wavetable::getHarmonicAmplitude(Shape shape, int harmonic)
+{
+	switch (shape)
+	{
+		case Square: return harmonic % 2 ? 4.0 / (M_PI * harmonic) : 0.0;
+		case Triangle: return harmonic % 2 ? (harmonic % 4 == 1 ? 8.0 : -8.0) / (M_PI * M_PI * harmonic * harmonic) : 0.0;
+		default: return -2.0 / (M_PI * harmonic); // Saw rising from -1 to 1
+	}
+}
+
+Wavetable::Wavetable(Shape shape)
+{
+	std::vector<double> sine(SIZE);
+	for (int i = 0; i < SIZE; i++)
+		sine[i] = std::sin(2.0 * M_PI * i / SIZE);
+
+	// Levels are built from the last one, each adding its harmonics to the ones of the level after it
+	std::vector<double> sum(SIZE, 0.0);
+	int harmonic = 1;
+	for (int level = LEVEL_COUNT - 1; level >= 0; level--)
+	{
+		for (; harmonic <= MAX_HARMONICS >> level; harmonic++)
+		{
+			const double amplitude = getHarmonicAmplitude(shape, harmonic);
+			if (amplitude == 0.0)
+				continue;
+			for (int i = 0; i < SIZE; i++)
+				sum[i] += amplitude * sine[(static_cast<long>(harmonic) * i) & (SIZE - 1)];
+		}
+
+		_levels[level].resize(SIZE + 1);
+		for (int i = 0; i < SIZE; i++)
+			_levels[level][i] = static_cast<float>(sum[i]);
+		_levels[level][SIZE] = _levels[level][0];
+	}
+}
+
+void Wavetable::render(float* out, const uint32_t* phases, uint32_t increment, int frames) const
+{
+	// Highest harmonic of the level must stay under half a cycle per frame
+	int level = 0;
+	while (level < LEVEL_COUNT - 1 && (MAX_HARMONICS >> level) * static_cast<uint64_t>(increment) > (uint64_t(1) << 31))
+		level++;
+
+	const float* table = _levels[level].data();
+	constexpr int FRACTION_BITS = 32 - SIZE_BITS;
+	constexpr float FRACTION_SCALE = 1.0f / (1 << FRACTION_BITS);
+	for (int i = 0; i < frames; i++)
+	{
+		const uint32_t index = phases[i] >> FRACTION_BITS;
+		const float fraction = (phases[i] & ((1u << FRACTION_BITS) - 1)) * FRACTION_SCALE;
+		out[i] = table[index] + fraction * (table[index + 1] - table[index]);
+	}
+}
@@ -53,7 +53,7 @@ void InputManager::updateModifierKey(unsigned int key, bool pressed)
 	keys[key].updateKeyData(pressed);
 }
 
-void InputManager::updateKeysState(const MidiPlayerSettings& settings, std::vector<MidiInfo>& keyPressed)
+void InputManager::updateKeysState(const MidiPlayerSettings& settings, VoicePool& keyPressed)
 {
 	// Mouse
 	double xpos, ypos;
@@ -68,8 +68,7 @@ void InputManager::updateKeysState(const MidiPlayerSettings& settings, std::vect
 		keys[i].updateKeyData((bool)glfwGetKey(_window, i));
 
 	// Reset rising edges
-	for (MidiInfo& info : keyPressed)
-		info.risingEdge = false;
+	keyPressed.clearRisingEdges();
 
 	if (settings.useKeyboardAsInput)
 	{
@@ -127,7 +126,7 @@ void InputManager::createKeysEvents(std::queue<Message>& messageQueue)
 		messageQueue.push(UI_CLEAR_FOCUS);
 }
 
-void InputManager::addKeyPressed(std::vector<MidiInfo>& keyPressed, int keyIndex, int velocity) const
+void InputManager::addKeyPressed(VoicePool& keyPressed, int keyIndex, int velocity) const
 {
 	MidiInfo info = {
 		keyIndex,
@@ -135,21 +134,16 @@ void InputManager::addKeyPressed(std::vector<MidiInfo>& keyPressed, int keyIndex
 		true, // rising edge
 	};
 
-	removeKeyPressed(keyPressed, keyIndex); // Remove key if it was not released for some reason
-
-	keyPressed.push_back(info);
+	// A key that was not released for some reason keeps its slot
+	if (keyPressed.press(info) == -1)
+		Logger::log("InputManager", Warning) << "Too many keys pressed, key " << keyIndex << " is ignored" << std::endl;
 }
 
-void InputManager::removeKeyPressed(std::vector<MidiInfo>& keyPressed, int keyIndex) const
+void InputManager::removeKeyPressed(VoicePool& keyPressed, int keyIndex) const
 {
-	for (auto it = keyPressed.begin(); it != keyPressed.end(); it++)
-	{
-		if (it->keyIndex == keyIndex)
-		{
-			keyPressed.erase(it);
-			break;
-		}
-	}
+	const int slot = keyPressed.find(keyIndex);
+	if (slot != -1)
+		keyPressed.free(slot);
 }
 
 void InputManager::pollMidiDevices(bool log)
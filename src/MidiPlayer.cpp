@@ -1,8 +1,9 @@
 #include "MidiPlayer.hpp"
 
-double AudioComponent::time = 0.0;
+std::mutex AudioComponent::graphMutex;
 unsigned int AudioComponent::nextId = 1;
 unsigned int KeyboardFrequency::keyIndex = 0;
+Tuning::Table KeyboardFrequency::frequencies = Tuning::EQUAL_TEMPERAMENT;
 
 MidiPlayer::MidiPlayer(const char* executableName, unsigned int windowWidth, unsigned int windowHeight)
 	: _midiPollingTimer(1.0)
@@ -30,10 +31,15 @@ MidiPlayer::MidiPlayer(const char* executableName, unsigned int windowWidth, uns
 
 	_ui = std::make_unique<UI>(_window->getWindow(), _audio, _applicationPath);
 	Logger::subscribeStream(Log::getStream()); // Duplicate all logs to UI
+
+	_audio.startRenderThread(_instruments);
 }
 
 MidiPlayer::~MidiPlayer()
 {
+	// Instruments are destroyed before the audio, stop processing them first
+	_audio.stopRenderThread();
+
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
@@ -55,7 +61,7 @@ void MidiPlayer::update()
 		_inputManager->updateKeysState(_settings, _keyPressed);
 		_inputManager->createKeysEvents(_messageQueue);
 
-		_audio.update(_instruments, _keyPressed);
+		_audio.publishKeyPressed(_keyPressed);
 
 		_ui->update(*_window, _audio, _instruments, _settings, _messageQueue, *_inputManager);
 		_ui->render();
@@ -74,6 +80,7 @@ void MidiPlayer::handleFrameProcessTime(const time_point& startTime)
 
 	auto sleepDuration = _targetFrameDuration - deltaTime;
 
+	// Audio is rendered on its own thread, a late frame only delays the UI
 	if (sleepDuration > std::chrono::duration<double>(0.0))
 	{
 		std::this_thread::sleep_for(sleepDuration * 0.9f);
@@ -81,14 +88,6 @@ void MidiPlayer::handleFrameProcessTime(const time_point& startTime)
 		while (endTime - startTime < _targetFrameDuration)
 			endTime = std::chrono::high_resolution_clock::now();
 	}
-	else
-	{
-		const double maxAllowedLag = (1.0 / _audio.getTargetFPS()) * _audio.getLatency();
-		if (deltaTime.count() - (1.0 / _audio.getTargetFPS()) > maxAllowedLag)
-		{
-			Logger::log("Audio", Warning) << "lag exceeded cursors safety gap" << std::endl;
-		}
-	}
 }
 
 fs::path MidiPlayer::findResourcesFolder(const fs::path& applicationPath, bool verbose)
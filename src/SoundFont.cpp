@@ -1,35 +1,125 @@
 #include "SoundFont.hpp"
+#include "SoundFontCache.hpp"
 
 SoundFont::~SoundFont()
 {
+	cancelLoading();
 	deleteLoadedSoundFont();
 }
 
-bool SoundFont::loadSoundFontFile(const fs::path& filepath, const unsigned int& sampleRate)
+void SoundFont::loadSoundFontFile(const fs::path& filepath)
 {
-	// Delete previous loaded instrument
-	deleteLoadedSoundFont();
-	_tinySoundFont = nullptr;
+	cancelLoading();
 
-	_tinySoundFont = tsf_load_filename(filepath.string().c_str());
-	if (_tinySoundFont == nullptr)
+	_loadingFilepath = filepath;
+	_loadFinished = false;
+	_cancelLoading = false;
+	_progress = 0.0f;
+	_loadedSoundFont = nullptr;
+	_openFailed = false;
+	_loader = std::thread(&SoundFont::load, this);
+}
+
+bool SoundFont::finishLoading()
+{
+	if (!_loader.joinable() || !_loadFinished)
+		return false;
+
+	_loader.join();
+	if (_loadedSoundFont == nullptr)
 	{
-		Logger::log("SoundFontPlayer", Error) << "Could not open file: " << filepath.string() << std::endl;
+		Logger::log("SoundFontPlayer", Error) << (_openFailed ? "Could not open file: " : "Invalid SoundFont file: ") << _loadingFilepath.string() << std::endl;
 		return true;
 	}
 
-	tsf_set_output(_tinySoundFont, TSF_MONO, sampleRate, 0);
+	deleteLoadedSoundFont();
+	_tinySoundFont = _loadedSoundFont;
+	_filepath = _loadingFilepath;
+	_loadedSoundFont = nullptr;
 
-	return false;
+	Logger::log("SoundFontPlayer", Info) << "Loaded SoundFont: " << _filepath.string() << std::endl;
+	return true;
 }
 
-void SoundFont::deleteLoadedSoundFont()
+// Runs on the loader thread
+void SoundFont::load()
 {
-	if (_tinySoundFont != nullptr)
+	const SoundFontCache::Key key = SoundFontCache::getKey(_loadingFilepath);
+	_loadedSoundFont = SoundFontCache::acquire(key);
+	if (_loadedSoundFont != nullptr)
 	{
-		tsf_note_off_all(_tinySoundFont);
-		tsf_close(_tinySoundFont);
+		_progress = 1.0f;
+		_loadFinished = true;
+		return;
 	}
+
+	LoadingStream stream = { this, std::ifstream(_loadingFilepath, std::ios::binary | std::ios::ate), 0, 0 };
+	if (!stream.file.is_open())
+	{
+		_openFailed = true;
+		_loadFinished = true;
+		return;
+	}
+
+	stream.size = stream.file.tellg();
+	stream.file.seekg(0);
+
+	tsf_stream tsfStream = { &stream, &LoadingStream::read, &LoadingStream::skip };
+	tsf* soundFont = tsf_load(&tsfStream);
+
+	// A cancelled load may still have parsed a valid sound font, it is not used
+	if (soundFont != nullptr && _cancelLoading)
+	{
+		tsf_close(soundFont);
+		soundFont = nullptr;
+	}
+
+	_loadedSoundFont = soundFont != nullptr ? SoundFontCache::insert(key, soundFont) : nullptr;
+	_loadFinished = true;
+}
+
+void SoundFont::cancelLoading()
+{
+	if (!_loader.joinable())
+		return;
+
+	_cancelLoading = true;
+	_loader.join();
+	SoundFontCache::release(_loadedSoundFont);
+	_loadedSoundFont = nullptr;
+}
+
+// Reading stops as soon as the load is cancelled, tsf_load then fails
+int SoundFont::LoadingStream::read(void* data, void* ptr, unsigned int size)
+{
+	LoadingStream* stream = static_cast<LoadingStream*>(data);
+	if (stream->soundFont->_cancelLoading)
+		return 0;
+
+	stream->file.read(static_cast<char*>(ptr), size);
+	const std::streamsize count = stream->file.gcount();
+	stream->position += count;
+	stream->soundFont->_progress = stream->size ? static_cast<float>(stream->position) / stream->size : 1.0f;
+	return static_cast<int>(count);
+}
+
+// Returns 1 on success, as the tsf stdio stream
+int SoundFont::LoadingStream::skip(void* data, unsigned int count)
+{
+	LoadingStream* stream = static_cast<LoadingStream*>(data);
+	if (stream->soundFont->_cancelLoading)
+		return 0;
+
+	stream->file.seekg(count, std::ios::cur);
+	stream->position += count;
+	return stream->file.good();
+}
+
+void SoundFont::deleteLoadedSoundFont()
+{
+	SoundFontCache::release(_tinySoundFont);
+	_tinySoundFont = nullptr;
+	_filepath.clear();
 }
 
 tsf* SoundFont::getSoundFont()
@@ -0,0 +1,96 @@
+#include "SoundFontCache.hpp"
+
+std::mutex SoundFontCache::_mutex;
+std::map<SoundFontCache::Key, SoundFontCache::Entry> SoundFontCache::_entries;
+std::unordered_map<tsf*, SoundFontCache::Key> SoundFontCache::_instances;
+
+tsf* SoundFontCache::acquire(const Key& key)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto it = _entries.find(key);
+	if (it == _entries.end())
+		return nullptr;
+
+	return copy(key, it->second);
+}
+
+tsf* SoundFontCache::insert(const Key& key, tsf* soundFont)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto it = _entries.find(key);
+	if (it != _entries.end())
+		tsf_close(soundFont);
+	else
+		it = _entries.insert({ key, { soundFont, 0 } }).first;
+
+	tsf* instance = copy(key, it->second);
+	if (instance == nullptr && it->second.instanceCount == 0)
+	{
+		tsf_close(it->second.soundFont);
+		_entries.erase(it);
+	}
+	return instance;
+}
+
+tsf* SoundFontCache::share(tsf* instance)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto instanceIt = _instances.find(instance);
+	if (instanceIt == _instances.end())
+		return nullptr;
+
+	const Key key = instanceIt->second;
+	return copy(key, _entries.at(key));
+}
+
+void SoundFontCache::release(tsf* instance)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto instanceIt = _instances.find(instance);
+	if (instanceIt == _instances.end())
+		return;
+
+	tsf_close(instance);
+
+	auto it = _entries.find(instanceIt->second);
+	_instances.erase(instanceIt);
+	if (--it->second.instanceCount == 0)
+	{
+		tsf_close(it->second.soundFont);
+		_entries.erase(it);
+	}
+}
+
+// Different paths to the same file share their entry, a file modified since it was cached does not
+SoundFontCache::Key SoundFontCache::getKey(const fs::path& filepath)
+{
+	std::error_code error;
+	Key key;
+	key.path = fs::weakly_canonical(filepath, error);
+	if (error)
+		key.path = filepath;
+
+	key.lastWriteTime = fs::last_write_time(key.path, error);
+	if (error)
+		key.lastWriteTime = fs::file_time_type::min();
+
+	key.size = fs::file_size(key.path, error);
+	if (error)
+		key.size = 0;
+	return key;
+}
+
+tsf* SoundFontCache::copy(const Key& key, Entry& entry)
+{
+	tsf* instance = tsf_copy(entry.soundFont);
+	if (instance == nullptr)
+		return nullptr;
+
+	entry.instanceCount++;
+	_instances[instance] = key;
+	return instance;
+}
@@ -35,9 +35,8 @@ void AudioSpectrum::update(const Audio& audio)
 
 void AudioSpectrum::processAudioSpectrum(const Audio& audio)
 {
-	// Find in audio buffer, sound that will be played this update
-	// which is not directly at writeCursor because of the latency.
-	int dataStart = (int)audio.getWriteCursorPos() - (int)(audio.getSamplesPerUpdate() * audio.getLatency());
+	// Find in the snapshot the last played samples
+	int dataStart = (int)audio.getSnapshotCursorPos() - SAMPLE_NB * (int)audio.getChannels();
 
 	// Make sure index is in buffer
 	dataStart = dataStart % (int)audio.getBufferSize();
@@ -47,10 +46,10 @@ void AudioSpectrum::processAudioSpectrum(const Audio& audio)
 	{
 		const int bufferIndex = (dataStart + i * audio.getChannels()) % audio.getBufferSize();
 
-		_arrayIn[i].r = hannWindowing(audio.getBuffer()[bufferIndex], i);
+		_arrayIn[i].r = hannWindowing(audio.getSnapshot()[bufferIndex], i);
 		if (audio.getChannels() == 2)
 		{
-			_arrayIn[i].r += hannWindowing(audio.getBuffer()[bufferIndex + 1], i);
+			_arrayIn[i].r += hannWindowing(audio.getSnapshot()[bufferIndex + 1], i);
 			_arrayIn[i].r /= 2.0;
 		}
 	}
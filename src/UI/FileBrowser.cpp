@@ -7,7 +7,7 @@ void FileBrowser::update(std::queue<Message>& messages)
 	if (_browser.HasSelected())
 	{
 		_isOpen = false;
-		messages.push(Message(SEND_NODE_FILEPATH, new NodeFilepathData({_browser.GetSelected(), _callerNodeId})));
+		messages.push(Message(_responseId, new NodeFilepathData({_browser.GetSelected(), _callerNodeId})));
 		_browser.ClearSelected();
 	}
 	else if (_isOpen == true && _browser.IsOpened() == false)
@@ -22,6 +22,7 @@ void FileBrowser::openFileBrowser(const FileBrowserOpenData& data)
 {
 	_isOpen = true;
 	_callerNodeId = data.nodeId;
+	_responseId = data.responseId;
 	_browser.SetTitle(data.title);
 	_browser.SetTypeFilters(data.filter);
 	_browser.Open();
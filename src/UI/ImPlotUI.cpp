@@ -48,14 +48,17 @@ void ImPlotUI::printPlot(Audio& audio, unsigned int offset, bool stereo)
 	ImPlot::SetupAxis(ImAxis_Y1, "Amplitude");
 	ImPlot::SetupAxisLimits(ImAxis_Y1, -1.0, 1.0); // Set Y axis go from -1 to +1
 	if (!stereo)
-		ImPlot::PlotLine("value", audio.getBuffer() + offset, audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
+		ImPlot::PlotLine("value", audio.getSnapshot() + offset, audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
 	else
 	{
-		ImPlot::PlotLine("left", audio.getBuffer(), audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
-		ImPlot::PlotLine("right", audio.getBuffer() + 1, audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
+		ImPlot::PlotLine("left", audio.getSnapshot(), audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
+		ImPlot::PlotLine("right", audio.getSnapshot() + 1, audio.getBufferSize() / audio.getChannels(), 1.0 / audio.getSampleRate(), 0, ImPlotLineFlags(), 0, audio.getChannels()*sizeof(float));
 	}
-	double writeCursorX = audio.getWriteCursorPos() / (double)audio.getSampleRate() / audio.getChannels();
-	double readCursorX = audio.getReadCursorPos() / (double)audio.getSampleRate() / audio.getChannels();
+	// Snapshot ends at the read cursor, the write cursor is placed ahead of it by the samples still buffered
+	const unsigned int bufferedSamples = (audio.getWriteCursorPos() - audio.getReadCursorPos()) & (audio.getBufferSize() - 1);
+	const unsigned int writeCursorPos = (audio.getSnapshotCursorPos() + bufferedSamples) & (audio.getBufferSize() - 1);
+	double writeCursorX = writeCursorPos / (double)audio.getSampleRate() / audio.getChannels();
+	double readCursorX = audio.getSnapshotCursorPos() / (double)audio.getSampleRate() / audio.getChannels();
 	double writeCursorXArray[2] = { writeCursorX, writeCursorX };
 	double readCursorXArray[2] = { readCursorX, readCursorX };
 	double cursorY[2] = { 0.0, 1.0 };
@@ -199,6 +199,7 @@ void NodeEditorUI::handleNodeCreation()
 					assert(links.size() == 1);
 					std::shared_ptr<Node> hiddenNode = _nodeManager.findNodeByPinId(links.begin()->OutputId.Get());
 
+					std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
 					_linkManager.removeLinksFromNodeId(_idManager, _nodeManager, hiddenNode->id);
 					_nodeManager.removeNode(_idManager, hiddenNode);
 				}
@@ -314,6 +315,9 @@ void NodeEditorUI::deleteNode(const ed::NodeId& id, std::queue<Message>& message
 	std::shared_ptr<Node>& node = _nodeManager.findNodeById(id);
 	if (node->type != UI_NodeType::MasterUI)
 	{
+		// Removed nodes may still be used by the render thread until the backend is updated
+		std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+
 		// Delete hidden nodes linked to pin in Slider mode
 		for (Pin& pin : node->inputs)
 		{
@@ -379,8 +383,11 @@ void NodeEditorUI::loadFile(Master& master, const fs::path& path)
 		return;
 	}
 
-	_nodeManager.removeAllNodes(_idManager);
-	_linkManager.removeAllLinks(_idManager);
+	{
+		std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+		_nodeManager.removeAllNodes(_idManager);
+		_linkManager.removeAllLinks(_idManager);
+	}
 
 	ImVector<LinkInfo> links;
 
@@ -406,8 +413,11 @@ void NodeEditorUI::loadFile(Master& master, const fs::path& path)
 
 void NodeEditorUI::loadFile(Master& master, std::stringstream& stream)
 {
-	_nodeManager.removeAllNodes(_idManager);
-	_linkManager.removeAllLinks(_idManager);
+	{
+		std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+		_nodeManager.removeAllNodes(_idManager);
+		_linkManager.removeAllLinks(_idManager);
+	}
 
 	ImVector<LinkInfo> links;
 
@@ -436,6 +446,8 @@ void NodeEditorUI::updateBackend(Master& master)
 	_UIModified = false;
 	Node::propertyChanged = false;
 	NodeUIManagers managers = {_nodeManager, _linkManager};
+
+	std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
 	UIToBackendAdapter::updateBackend(master, managers);
 }
 
@@ -627,13 +639,6 @@ void NodeEditorUI::setNodeFilepathData(const NodeFilepathData& data)
 
 void NodeEditorUI::updateNodeSampleRate(const unsigned int sampleRate)
 {
+	// Sound font players follow the sample rate of the audio infos they are processed with
 	Node::audioInfos.sampleRate = sampleRate;
-
-	std::list<std::shared_ptr<Node>> nodes = _nodeManager.getNodeOfType<SoundFontPlayerNode>();
-	for (auto& node : nodes)
-	{
-		SoundFontPlayerNode* soundFontPlayerNode = dynamic_cast<SoundFontPlayerNode*>(node.get());
-		if (!soundFontPlayerNode->soundFontFilepath.empty())
-			soundFontPlayerNode->needToUpdateSoundFontFile = true;
-	}
 }
@@ -161,6 +161,7 @@ void UI::update(Window& window, Audio& audio, std::vector<Instrument>& instrumen
 	//updateLoadedInstruments(instruments, selectedInstrument, loadDefaultInstrument);
 
 	_nodeEditor.update(_selectedInstrument->master, messageQueue, instruments, _selectedInstrument);
+	audio.updateSnapshot();
 	_imPlot.update(audio, messageQueue, settings);
 	_audioSpectrum.update(audio);
 	_fileBrowser.update(messageQueue);
@@ -388,9 +389,18 @@ void UI::processEventQueue(std::queue<Message>& messageQueue)
 				delete data;
 				break;
 			}
+			case SEND_TUNING_FILEPATH : {
+				const NodeFilepathData* data = (NodeFilepathData*)message.data;
+				loadTuningFile(data->filepath);
+				delete data;
+				break;
+			}
 			case AUDIO_SAMPLE_RATE_UPDATED : {
 				const unsigned int* sampleRate = (unsigned int*)message.data;
 				_nodeEditor.updateNodeSampleRate(*sampleRate);
+				// Components size their delay lines for the sample rate when compiled
+				if (_selectedInstrument)
+					_nodeEditor.updateBackend(_selectedInstrument->master);
 				delete sampleRate;
 				break;
 			}
@@ -417,7 +427,11 @@ void UI::createNewInstrument(std::vector<Instrument>& instruments)
 		return;
 	}
 
-	instruments.push_back(Instrument());
+	{
+		// Vector reallocation would move instruments under the render thread
+		std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+		instruments.push_back(Instrument());
+	}
 	instruments.back().name = "instrument" + std::to_string(instruments.size() - 1);
 	if (instruments.size() == 1) // Auto-select new instrument if no other existing
 	{
@@ -10,6 +10,9 @@ void UIToBackendAdapter::updateBackend(Master& master, NodeUIManagers& managers)
 	std::vector<BackendInstruction*> instructions;
 	createInstructions(&master, &master, &UIMaster, managers, instructions);
 	processInstructions(master, UIMaster, managers, instructions);
+
+	// Links may have changed, rebuild the schedule used by the render thread
+	master.compile(Node::audioInfos.sampleRate);
 }
 
 void UIToBackendAdapter::processInstructions(Master& master, Node& UIMaster, NodeUIManagers& managers, std::vector<BackendInstruction*>& instructions)
@@ -14,12 +14,23 @@ void UI::updateSettings(Audio& audio, InputManager& inputManager, MidiPlayerSett
 		updateAudioChannels(audio, messageQueue);
 		updateAudioLatency(audio);
 		updateMuteAudio(audio);
+		updateMathPrecision();
 		ImGui::Text("\n");
 		ImGui::Unindent();
 
+		if (_selectedInstrument)
+		{
+			ImGui::SeparatorText("Instrument");
+			ImGui::Indent();
+			updateVoiceSettings(*_selectedInstrument);
+			ImGui::Text("\n");
+			ImGui::Unindent();
+		}
+
 		ImGui::SeparatorText("MIDI");
 		ImGui::Indent();
 		updateMidiSettings(inputManager, settings);
+		updateTuning(messageQueue);
 		ImGui::Text("\n");
 		ImGui::Unindent();
 
@@ -154,6 +165,44 @@ void UI::updateMuteAudio(Audio& audio)
 	helpMarker("Does not output sound to system but keeps updating audio generation.");
 }
 
+void UI::updateMathPrecision()
+{
+	const char* items[] = { Simd::getPrecisionName(Simd::Fast), Simd::getPrecisionName(Simd::Accurate), Simd::getPrecisionName(Simd::Exact) };
+	int selectedItem = Simd::getPrecision();
+
+	ImGui::Text("Math precision");
+	ImGui::SameLine();
+	helpMarker("Approximations used by oscillators and overdrives.\nFast: errors up to 1e-3, Accurate: errors up to 1e-4, Exact: standard library, slower.");
+	ImGui::SameLine();
+	ImGui::PushID("MathPrecisionCombo");
+	ImGui::SetNextItemWidth(125);
+	if (ImGui::Combo("", &selectedItem, items, sizeof(items) / sizeof(const char*)))
+	{
+		Logger::log("Settings") << "Changed math precision to " << items[selectedItem] << std::endl;
+		Simd::setPrecision(static_cast<Simd::Precision>(selectedItem));
+	}
+	ImGui::PopID();
+}
+
+void UI::updateVoiceSettings(Instrument& instrument)
+{
+	// Voices are read by the render thread
+	std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+
+	ImGui::Text("Voice limit");
+	ImGui::SameLine();
+	helpMarker("Maximum number of notes played at once, pressed or released.\nPast it, released then quietest then oldest notes are stolen.");
+	ImGui::SameLine();
+	int voiceLimit = instrument.master.getVoiceLimit();
+	ImGui::SetNextItemWidth(300);
+	ImGui::PushID("VoiceLimitSlider");
+	if (ImGui::SliderInt("", &voiceLimit, 1, MAX_VOICES - 1, "%d", ImGuiSliderFlags_AlwaysClamp))
+		instrument.master.setVoiceLimit(voiceLimit);
+	ImGui::PopID();
+
+	ImGui::Text("Stolen voices: %lu", instrument.master.getStolenVoiceCount());
+}
+
 void UI::updateMidiSettings(InputManager& inputManager, MidiPlayerSettings& settings)
 {
 	const std::string currentMidiDeviceUsed = inputManager.getMidiDeviceUsed();
@@ -219,6 +268,40 @@ void UI::updateMidiSettings(InputManager& inputManager, MidiPlayerSettings& sett
 	ImGui::PopID();
 }
 
+void UI::updateTuning(std::queue<Message>& messageQueue)
+{
+	ImGui::Text("Tuning: %s, keyboard mapping: %s", _tuning.getScaleName().c_str(), _tuning.getMappingName().c_str());
+	ImGui::SameLine();
+	helpMarker("Scala files, shared by every instrument.\nA scale (.scl) gives the pitch of each degree, a keyboard mapping (.kbm) the degree\nplayed by each key and the key tuned to the reference frequency.");
+
+	if (ImGui::Button("Load scale"))
+		messageQueue.push(Message(UI_SHOW_FILE_BROWSER, new FileBrowserOpenData({"Load Scala scale file", {".scl"}, 0, SEND_TUNING_FILEPATH})));
+	ImGui::SameLine();
+	if (ImGui::Button("Load keyboard mapping"))
+		messageQueue.push(Message(UI_SHOW_FILE_BROWSER, new FileBrowserOpenData({"Load Scala keyboard mapping file", {".kbm"}, 0, SEND_TUNING_FILEPATH})));
+	ImGui::SameLine();
+	if (ImGui::Button("Reset to 12-TET"))
+	{
+		_tuning.reset();
+		std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+		KeyboardFrequency::setFrequencies(_tuning.getFrequencies());
+	}
+}
+
+void UI::loadTuningFile(const fs::path& filepath)
+{
+	const bool error = filepath.extension() == ".kbm" ? _tuning.loadKeyboardMapping(filepath) : _tuning.loadScale(filepath);
+	if (error)
+	{
+		ImGui::InsertNotification({ImGuiToastType::Error, 5000, "Failed to load tuning file %s", filepath.filename().string().c_str()});
+		return;
+	}
+
+	// Table is read by the render thread
+	std::lock_guard<std::mutex> lock(AudioComponent::graphMutex);
+	KeyboardFrequency::setFrequencies(_tuning.getFrequencies());
+}
+
 void UI::updateUISettings(MidiPlayerSettings& settings)
 {
 	ImGuiIO& io = ImGui::GetIO();
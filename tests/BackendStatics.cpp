@@ -0,0 +1,7 @@
+#include "AudioBackend/Components/Components.hpp"
+
+// Static members defined by MidiPlayer.cpp in the application
+std::mutex AudioComponent::graphMutex;
+unsigned int AudioComponent::nextId = 1;
+unsigned int KeyboardFrequency::keyIndex = 0;
+Tuning::Table KeyboardFrequency::frequencies = Tuning::EQUAL_TEMPERAMENT;
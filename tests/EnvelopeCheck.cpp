@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "config.hpp"
+#include "envelope.hpp"
+
+/*
+ * Checks envelopes evaluated by forward differencing against the Bézier curve of each phase evaluated
+ * at every frame, as envelopes were rendered before their segments were precomputed.
+ * Shapes are random and edited while notes play, keys are pressed and released at random frames.
+ * Blocks are rendered at audio rate or at control rate, where each output must match the reference
+ * at the frame it stands for.
+*/
+
+static constexpr double SAMPLE_RATE = 44100.0;
+static constexpr int BLOCK_COUNT = 40000;
+static constexpr double MAX_ERROR = 1e-6;
+
+// Envelope of one voice evaluated from the control points at every frame
+struct ReferenceEnvelope {
+	Phase phase = Inactive;
+	bool noteOn = false;
+	unsigned long frame = 0;
+	double amplitude = 0.0;
+	double start = 0.0;
+
+	double render(const EnvelopeShape& shape, bool pressed)
+	{
+		if (pressed != noteOn)
+		{
+			noteOn = pressed;
+			frame = 0;
+			start = amplitude;
+			phase = !pressed ? Release : phase == Release ? Retrigger : Attack;
+		}
+		while (frame > getPhaseEnd(shape))
+			phase = phase == Attack || phase == Retrigger ? Decay : phase == Decay ? Sustain : Inactive;
+
+		const Vec2* points = shape.controlPoints;
+		const double time = frame / SAMPLE_RATE;
+		double value = 0.0;
+		switch (phase)
+		{
+			case Attack: value = bezier(points[0].y, points[1].y, points[2].y, inverseLerp(points[0].x, points[2].x, time)); break;
+			case Decay: value = bezier(points[2].y, points[3].y, points[4].y, inverseLerp(points[2].x, points[4].x, time)); break;
+			case Sustain: value = points[4].y; break;
+			case Release: value = bezier(start, points[6].y, points[7].y, inverseLerp(0.0, points[7].x - points[5].x, time)); break;
+			case Retrigger: value = start + (time / points[2].x) * (points[2].y - start); break;
+			default: break;
+		}
+
+		amplitude = value <= 0.0001 ? 0.0 : value;
+		frame++;
+		return amplitude;
+	}
+
+	unsigned long getPhaseEnd(const EnvelopeShape& shape) const
+	{
+		switch (phase)
+		{
+			case Attack: case Retrigger: return shape.attackEnd;
+			case Decay: return shape.decayEnd;
+			case Release: return shape.releaseEnd;
+			default: return ~0ul;
+		}
+	}
+
+	static double bezier(double p0, double p1, double p2, double t)
+	{
+		return (1.0 - t) * (1.0 - t) * p0 + 2.0 * (1.0 - t) * t * p1 + t * t * p2;
+	}
+};
+
+// Phases of 10 ms to 1 s, levels in [0, 1]
+static void randomizeShape(EnvelopeShape& shape, std::mt19937& random)
+{
+	std::uniform_real_distribution<float> duration(0.01f, 1.0f);
+	std::uniform_real_distribution<float> level(0.0f, 1.0f);
+
+	Vec2 points[8];
+	const float attackEnd = duration(random), decayEnd = attackEnd + duration(random), release = duration(random);
+	points[0] = { 0.0f, 0.0f };
+	points[1] = { attackEnd * level(random), level(random) };
+	points[2] = { attackEnd, level(random) };
+	points[3] = { attackEnd + (decayEnd - attackEnd) * level(random), level(random) };
+	points[4] = { decayEnd, level(random) };
+	points[5] = { decayEnd + 0.1f, points[4].y };
+	points[6] = { points[5].x + release * level(random), level(random) };
+	points[7] = { points[5].x + release, 0.0f };
+	shape.setControlPoints(points);
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> blockFrames(1, MAX_BLOCK_FRAMES);
+	std::uniform_int_distribution<int> event(0, 999);
+	std::uniform_int_distribution<int> controlRate(0, 1);
+
+	EnvelopeShape shape;
+	shape.setSampleRate(SAMPLE_RATE);
+	randomizeShape(shape, random);
+
+	sEnvelopeADSR envelope;
+	ReferenceEnvelope reference;
+	bool pressed = false;
+	double maxError = 0.0;
+
+	float out[MAX_BLOCK_FRAMES];
+	for (int block = 0; block < BLOCK_COUNT; block++)
+	{
+		// Keys are held for about 200 blocks, control points are moved about every 500 blocks
+		const int draw = event(random);
+		if (draw < 5)
+			pressed = !pressed;
+		else if (draw < 7)
+			randomizeShape(shape, random);
+
+		const int stride = controlRate(random) ? CONTROL_RATE_FRAMES : 1;
+		const int outputs = (blockFrames(random) + stride - 1) / stride;
+		envelope.render(shape, pressed, out, outputs, stride);
+
+		double expected = 0.0;
+		for (int i = 0; i < outputs * stride; i++)
+		{
+			const double value = reference.render(shape, pressed);
+			if (i % stride != 0)
+				continue;
+
+			expected = value;
+			// Relative to amplitudes above 1, which a phase extrapolates to when an edit moves its start after the current frame
+			const double error = std::abs(out[i / stride] - expected) / std::max(std::abs(expected), 1.0);
+			if (error > MAX_ERROR)
+			{
+				std::cerr << "Envelope is " << out[i / stride] << " instead of " << expected << " in block " << block
+					<< " of stride " << stride << ", phase " << reference.phase << ", frame " << reference.frame - 1 << std::endl;
+				return 1;
+			}
+			maxError = std::max(maxError, error);
+		}
+		// Frames between the outputs are never computed, a release starts from the last output
+		reference.amplitude = expected;
+	}
+
+	std::cout << "Max error " << maxError << std::endl;
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+#include "AudioBackend/Components/Oscillator.hpp"
+
+/*
+ * Checks the noise kernels of the SIMD level selected on this machine.
+ * White noise must be bit-identical to the scalar xorshift generators, pink and brown noise must stay
+ * close to the double precision recursions they replaced when fed the same white noise.
+ * Blocks have random sizes so that the chunked filters also run their partial chunks.
+*/
+
+static constexpr int BLOCK_COUNT = 20000;
+static constexpr double MAX_PINK_ERROR = 2.5e-7;
+static constexpr double MAX_BROWN_ERROR = 2e-6;
+
+static uint32_t xorshift(uint32_t x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	return x ^ (x << 5);
+}
+
+int main()
+{
+	std::mt19937 random(1);
+	std::uniform_int_distribution<int> blockFrames(1, MAX_BLOCK_FRAMES);
+
+	uint32_t states[Simd::NOISE_LANES], referenceStates[Simd::NOISE_LANES];
+	for (int lane = 0; lane < Simd::NOISE_LANES; lane++)
+		states[lane] = referenceStates[lane] = 0x9e3779b9u * (lane + 1);
+
+	float pinkState[Simd::PINK_STATE_SIZE] = {};
+	float brownState = 0.0f;
+	double pinkReference[3] = {};
+	double brownReference = 0.0;
+	double pinkError = 0.0, brownError = 0.0;
+
+	AudioBlock white, pink, brown;
+	for (int block = 0; block < BLOCK_COUNT; block++)
+	{
+		const int frames = blockFrames(random);
+		Simd::whiteNoise(white.data(), states, frames);
+		Simd::pinkNoise(pink.data(), white.data(), pinkState, frames);
+		Simd::brownNoise(brown.data(), white.data(), &brownState, frames);
+
+		for (int i = 0; i < frames; i++)
+		{
+			uint32_t& state = referenceStates[i % Simd::NOISE_LANES];
+			state = xorshift(state);
+			const float expected = static_cast<float>(static_cast<int32_t>(state)) * (1.0f / 2147483648.0f);
+			if (white[i] != expected)
+			{
+				std::cerr << "White noise differs from the scalar generators in block " << block << ": "
+					<< white[i] << " instead of " << expected << std::endl;
+				return 1;
+			}
+
+			// Paul Kellet's refined filter and the bounded integration, as rendered before the kernels
+			pinkReference[0] = 0.99765 * pinkReference[0] + white[i] * 0.0990460;
+			pinkReference[1] = 0.96300 * pinkReference[1] + white[i] * 0.2965164;
+			pinkReference[2] = 0.57000 * pinkReference[2] + white[i] * 1.0526913;
+			const double pinkExpected = (pinkReference[0] + pinkReference[1] + pinkReference[2] + white[i] * 0.1848) / 20.0;
+			brownReference = std::clamp(brownReference + white[i] * 0.02, -1.0, 1.0);
+
+			pinkError = std::max(pinkError, std::abs(pink[i] - pinkExpected));
+			brownError = std::max(brownError, std::abs(brown[i] - brownReference));
+		}
+	}
+
+	std::cout << "Level " << Simd::getLevelName(Simd::getLevel()) << ", pink error " << pinkError
+		<< ", brown error " << brownError << std::endl;
+	if (pinkError > MAX_PINK_ERROR || brownError > MAX_BROWN_ERROR)
+	{
+		std::cerr << "Noise filters too far from the double precision recursions" << std::endl;
+		return 1;
+	}
+
+	// Oscillators seeded alike render the same noise, voices and seeds draw from different generators
+	Oscillator first, second, other;
+	first.type = second.type = other.type = PinkNoise;
+	first.seedNoise(7);
+	second.seedNoise(7);
+	other.seedNoise(8);
+
+	AudioBlock firstBlock, secondBlock, voiceBlock, otherBlock;
+	for (int block = 0; block < 100; block++)
+	{
+		first.renderNoise(firstBlock.data(), 0, MAX_BLOCK_FRAMES);
+		second.renderNoise(secondBlock.data(), 0, MAX_BLOCK_FRAMES);
+		second.renderNoise(voiceBlock.data(), 1, MAX_BLOCK_FRAMES);
+		other.renderNoise(otherBlock.data(), 0, MAX_BLOCK_FRAMES);
+
+		if (firstBlock != secondBlock)
+		{
+			std::cerr << "Oscillators with the same seed rendered different noise in block " << block << std::endl;
+			return 1;
+		}
+		if (firstBlock == voiceBlock || firstBlock == otherBlock)
+		{
+			std::cerr << "Different voices or seeds rendered the same noise in block " << block << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "AudioBackend/Components/Components.hpp"
+#include "AudioBackend/Instrument.hpp"
+
+/*
+ * Checks that evaluating note-invariant subgraphs once per voice does not change the render.
+ * The same patch is rendered with its note-invariant components, which the plan hoists out of the schedule,
+ * and with copies of them that do not declare it, which are processed every block as before.
+ * Both renders must be bit-identical, including when the tuning changes while notes are held.
+ *
+ * The patch has no envelope: branches skipped behind a closed gate advance their oscillators exactly only
+ * when the frequency is a note constant, so gated patches are not expected to render the same.
+*/
+
+static constexpr AudioInfos AUDIO_INFOS = { 44100, 2 };
+static constexpr int BLOCK_COUNT = 1000;
+static constexpr int RETUNE_BLOCK = 400;
+
+// Component processed every block like any other
+template<typename Component>
+struct Scheduled : public Component {
+	bool dependsOnlyOnNote() const override { return false; }
+};
+
+static Number* constant(float value)
+{
+	Number* number = new Number();
+	number->number = value;
+	return number;
+}
+
+/*
+ * Saw an octave below the keyboard, plus a sine whose frequency goes through an overdrive:
+ * 1000 * tanh(0.001 * frequency).
+*/
+template<typename KeyboardFrequencyType, typename MultiplierType, typename OverdriveType>
+static void buildPatch(Master& master)
+{
+	KeyboardFrequency* keyboard = new KeyboardFrequencyType();
+
+	MultiplierType* transposed = new MultiplierType();
+	transposed->addInput(Multiplier::inputA, keyboard);
+	transposed->addInput(Multiplier::inputB, constant(0.5f));
+	Oscillator* saw = new Oscillator();
+	saw->type = PolyBlepSaw;
+	saw->addInput(Oscillator::frequency, transposed);
+
+	MultiplierType* scaledDown = new MultiplierType();
+	scaledDown->addInput(Multiplier::inputA, keyboard);
+	scaledDown->addInput(Multiplier::inputB, constant(0.001f));
+	OverdriveType* saturated = new OverdriveType();
+	saturated->addInput(Overdrive::input, scaledDown);
+	saturated->addInput(Overdrive::drive, constant(1.0f));
+	MultiplierType* scaledUp = new MultiplierType();
+	scaledUp->addInput(Multiplier::inputA, saturated);
+	scaledUp->addInput(Multiplier::inputB, constant(1000.0f));
+	Oscillator* sine = new Oscillator();
+	sine->type = Sine;
+	sine->addInput(Oscillator::frequency, scaledUp);
+
+	Multiplier* volume = new Multiplier();
+	volume->addInput(Multiplier::inputA, saw);
+	volume->addInput(Multiplier::inputA, sine);
+	volume->addInput(Multiplier::inputB, constant(0.2f));
+	master.addInput(0, volume);
+}
+
+// Stereo blocks of a new instrument one after the other, retuned a semitone up at RETUNE_BLOCK when retune is set
+template<typename KeyboardFrequencyType, typename MultiplierType, typename OverdriveType>
+static std::vector<float> render(bool retune)
+{
+	KeyboardFrequency::setFrequencies(Tuning::EQUAL_TEMPERAMENT);
+	Instrument instrument;
+	buildPatch<KeyboardFrequencyType, MultiplierType, OverdriveType>(instrument.master);
+	instrument.master.compile(AUDIO_INFOS.sampleRate);
+
+	Tuning::Table raised = Tuning::EQUAL_TEMPERAMENT;
+	for (int note = 0; note + 1 < NOTE_COUNT; note++)
+		raised[note] = Tuning::EQUAL_TEMPERAMENT[note + 1];
+
+	VoicePool none = {}, chord = {}, single = {};
+	chord.press({ 60, 127, true });
+	chord.press({ 64, 100, true });
+	single.press({ 60, 127, true });
+
+	std::vector<float> out(BLOCK_COUNT * 2 * MAX_BLOCK_FRAMES);
+	for (int block = 0; block < BLOCK_COUNT; block++)
+	{
+		if (retune && block == RETUNE_BLOCK)
+			KeyboardFrequency::setFrequencies(raised);
+
+		const VoicePool& keys = block < 50 ? none : block < 600 ? chord : block < 800 ? single : none;
+		const double time = static_cast<double>(block * MAX_BLOCK_FRAMES) / AUDIO_INFOS.sampleRate;
+		instrument.processBlock(AUDIO_INFOS, keys, time, out.data() + block * 2 * MAX_BLOCK_FRAMES, MAX_BLOCK_FRAMES);
+	}
+	return out;
+}
+
+int main()
+{
+	for (bool retune : { false, true })
+	{
+		const std::vector<float> hoistedOut = render<KeyboardFrequency, Multiplier, Overdrive>(retune);
+		const std::vector<float> scheduledOut = render<Scheduled<KeyboardFrequency>, Scheduled<Multiplier>, Scheduled<Overdrive>>(retune);
+		for (size_t i = 0; i < hoistedOut.size(); i++)
+		{
+			if (hoistedOut[i] != scheduledOut[i])
+			{
+				std::cerr << "Renders differ in block " << i / (2 * MAX_BLOCK_FRAMES) << (retune ? " with" : " without")
+					<< " retuning: " << hoistedOut[i] << " instead of " << scheduledOut[i] << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	// Held notes follow the new tuning from the block it is loaded in
+	const std::vector<float> tuned = render<KeyboardFrequency, Multiplier, Overdrive>(false);
+	const std::vector<float> retuned = render<KeyboardFrequency, Multiplier, Overdrive>(true);
+	const size_t retuneStart = RETUNE_BLOCK * 2 * MAX_BLOCK_FRAMES;
+	if (!std::equal(tuned.begin(), tuned.begin() + retuneStart, retuned.begin()))
+	{
+		std::cerr << "Render changed before the tuning was loaded" << std::endl;
+		return 1;
+	}
+	if (std::equal(tuned.begin() + retuneStart, tuned.begin() + retuneStart + 2 * MAX_BLOCK_FRAMES, retuned.begin() + retuneStart))
+	{
+		std::cerr << "Held notes did not follow the new tuning" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
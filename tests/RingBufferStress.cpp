@@ -0,0 +1,79 @@
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "RingBuffer.hpp"
+
+/*
+ * Single producer / single consumer stress test of RingBuffer.
+ * The producer writes an increasing sequence in chunks of varying size, the consumer checks
+ * every value it reads. Meant to be run in a SANITIZE_THREAD build, where any missing
+ * synchronization between the cursors and the data is reported as a data race.
+*/
+
+static constexpr uint32_t VALUE_COUNT = 1 << 22;
+static constexpr size_t CAPACITY = 1000; // Rounded up to 1024, chunks wrap around the end of the storage
+
+int main()
+{
+	RingBuffer<uint32_t> buffer(CAPACITY);
+	if (buffer.getCapacity() != 1024)
+	{
+		std::cerr << "Capacity not rounded up to a power of two: " << buffer.getCapacity() << std::endl;
+		return 1;
+	}
+
+	std::thread producer([&buffer]() {
+		std::vector<uint32_t> chunk(CAPACITY);
+		uint32_t next = 0;
+		size_t chunkSize = 1;
+		while (next < VALUE_COUNT)
+		{
+			const size_t count = std::min<size_t>(chunkSize, VALUE_COUNT - next);
+			for (size_t i = 0; i < count; i++)
+				chunk[i] = next + i;
+
+			next += buffer.write(chunk.data(), count);
+			chunkSize = chunkSize % 733 + 1;
+			if (buffer.writeAvailable() == 0)
+				std::this_thread::yield();
+		}
+	});
+
+	std::vector<uint32_t> chunk(CAPACITY);
+	uint32_t expected = 0;
+	size_t chunkSize = 1;
+	bool skipping = false;
+	while (expected < VALUE_COUNT)
+	{
+		// Skipped values are checked by the next read
+		const size_t count = skipping ? buffer.skip(chunkSize) : buffer.read(chunk.data(), chunkSize);
+		for (size_t i = 0; !skipping && i < count; i++)
+		{
+			if (chunk[i] != expected + i)
+			{
+				std::cerr << "Read " << chunk[i] << " instead of " << expected + i << std::endl;
+				producer.join();
+				return 1;
+			}
+		}
+
+		expected += count;
+		skipping = !skipping && chunkSize % 5 == 0;
+		chunkSize = chunkSize % 911 + 1;
+		if (count == 0)
+			std::this_thread::yield();
+	}
+
+	producer.join();
+
+	if (buffer.readAvailable() != 0)
+	{
+		std::cerr << "Buffer not empty after reading every value" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Read " << VALUE_COUNT << " values" << std::endl;
+	return 0;
+}
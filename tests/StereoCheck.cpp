@@ -0,0 +1,169 @@
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "AudioBackend/Components/Components.hpp"
+#include "AudioBackend/Instrument.hpp"
+
+/*
+ * Checks that stereo outputs are carried to the instrument output channel by channel.
+ * Each patch is rendered with a stereo source, then with mono sources playing its left or its right channel.
+ * The left and right channels of the stereo render must be bit-identical to the mono renders, which must
+ * themselves have the same left and right channels. Components that do not keep both channels read the average of the two.
+*/
+
+static constexpr AudioInfos AUDIO_INFOS = { 44100, 2 };
+static constexpr int BLOCK_COUNT = 400;
+static constexpr int PATCH_COUNT = 6;
+
+// Different signals on each channel, depending on the note and on the frames played by the voice
+struct TestSignal : public AudioComponent {
+	enum Channels { Stereo, Left, Right, Average };
+	Channels channels;
+	std::array<unsigned long, MAX_VOICES> positions = {};
+
+	explicit TestSignal(Channels channels) : AudioComponent(), channels(channels) { componentName = "TestSignal"; }
+
+	int getOutputChannels() const override { return channels == Stereo ? 2 : 1; }
+
+	void resetVoice(int voice) override { positions[voice] = 0; }
+
+	void skipBlock(const AudioInfos& audioInfos, VoiceContext& context, int frames) override
+	{
+		positions[context.voice] += frames;
+	}
+
+	void processBlock(const AudioInfos& audioInfos, VoiceContext& context, float* out, int frames) override
+	{
+		unsigned long& position = positions[context.voice];
+		const float pitch = context.key ? 0.0001f * context.key->keyIndex : 0.0f;
+		for (int i = 0; i < frames; i++, position++)
+		{
+			const float left = std::sin((0.01f + pitch) * position);
+			const float right = 0.5f * std::cos(0.013f * position);
+			switch (channels)
+			{
+				case Stereo: out[i] = left; out[frames + i] = right; break;
+				case Left: out[i] = left; break;
+				case Right: out[i] = right; break;
+				case Average: out[i] = 0.5f * (left + right); break;
+			}
+		}
+	}
+};
+
+static Number* constant(float value)
+{
+	Number* number = new Number();
+	number->number = value;
+	return number;
+}
+
+// Stereo blocks of the patch one after the other
+static std::vector<float> render(int patch, TestSignal::Channels channels)
+{
+	Instrument instrument;
+	Master& master = instrument.master;
+	TestSignal* source = new TestSignal(channels);
+
+	switch (patch)
+	{
+		case 0: // Mixed by master
+			master.addInput(0, source);
+			break;
+		case 1: { // Scaled by a factorized multiplier
+			Multiplier* volume = new Multiplier();
+			volume->addInput(Multiplier::inputA, source);
+			volume->addInput(Multiplier::inputB, constant(0.5f));
+			master.addInput(0, volume);
+			break;
+		}
+		case 2: { // Shaped by an envelope, which gates the source
+			ADSR* envelope = new ADSR();
+			envelope->addInput(ADSR::input, constant(1.0f));
+			envelope->addInput(ADSR::trigger, new KeyboardFrequency());
+			Multiplier* shaped = new Multiplier();
+			shaped->addInput(Multiplier::inputA, source);
+			shaped->addInput(Multiplier::inputB, envelope);
+			master.addInput(0, shaped);
+			break;
+		}
+		case 3: { // Also read by a mono component, which reads the average of the channels
+			Overdrive* overdrive = new Overdrive();
+			overdrive->addInput(Overdrive::input, channels == TestSignal::Stereo ? source : new TestSignal(TestSignal::Average));
+			overdrive->addInput(Overdrive::drive, constant(2.0f));
+			master.addInput(0, source);
+			master.addInput(0, overdrive);
+			break;
+		}
+		case 4: { // Mixed with a mono oscillator
+			Oscillator* oscillator = new Oscillator();
+			oscillator->type = Sine;
+			oscillator->addInput(Oscillator::frequency, constant(440.0f));
+			master.addInput(0, oscillator);
+			master.addInput(0, source);
+			break;
+		}
+		case 5: { // Scaled by a factorized multiplier, which sums its inputs once recompiled and then reads the average
+			if (channels != TestSignal::Stereo)
+				source->channels = TestSignal::Average;
+			Multiplier* volume = new Multiplier();
+			volume->addInput(Multiplier::inputA, source);
+			volume->addInput(Multiplier::inputB, constant(0.5f));
+			master.addInput(0, volume);
+			master.compile(AUDIO_INFOS.sampleRate);
+
+			Oscillator* oscillator = new Oscillator();
+			oscillator->type = Sine;
+			oscillator->addInput(Oscillator::frequency, constant(440.0f));
+			volume->addInput(Multiplier::inputA, oscillator);
+			break;
+		}
+	}
+	master.compile(AUDIO_INFOS.sampleRate);
+
+	VoicePool none = {}, chord = {};
+	chord.press({ 60, 127, true });
+	chord.press({ 64, 100, true });
+
+	std::vector<float> out(BLOCK_COUNT * 2 * MAX_BLOCK_FRAMES);
+	for (int block = 0; block < BLOCK_COUNT; block++)
+	{
+		const VoicePool& keys = block < 20 || block >= 300 ? none : chord;
+		const double time = static_cast<double>(block * MAX_BLOCK_FRAMES) / AUDIO_INFOS.sampleRate;
+		instrument.processBlock(AUDIO_INFOS, keys, time, out.data() + block * 2 * MAX_BLOCK_FRAMES, MAX_BLOCK_FRAMES);
+	}
+	return out;
+}
+
+int main()
+{
+	for (int patch = 0; patch < PATCH_COUNT; patch++)
+	{
+		const std::vector<float> stereo = render(patch, TestSignal::Stereo);
+		const std::vector<float> left = render(patch, TestSignal::Left);
+		const std::vector<float> right = render(patch, TestSignal::Right);
+
+		for (int block = 0; block < BLOCK_COUNT; block++)
+		{
+			const size_t start = block * 2 * MAX_BLOCK_FRAMES;
+			for (size_t i = start; i < start + MAX_BLOCK_FRAMES; i++)
+			{
+				const size_t rightIndex = i + MAX_BLOCK_FRAMES;
+				if (left[i] != left[rightIndex] || right[i] != right[rightIndex])
+				{
+					std::cerr << "Mono patch " << patch << " has different channels in block " << block << std::endl;
+					return 1;
+				}
+				if (stereo[i] != left[i] || stereo[rightIndex] != right[i])
+				{
+					std::cerr << "Patch " << patch << " renders " << stereo[i] << ", " << stereo[rightIndex] << " instead of "
+						<< left[i] << ", " << right[i] << " in block " << block << std::endl;
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}